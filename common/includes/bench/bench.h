@@ -0,0 +1,251 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace xcl {
+
+/*!
+ * Synopsis:
+ * 1.Runs a timed body a number of warmup times, then a number of measured
+ *      repetitions.
+ * 2.Rejects outliers (samples further than outlier_mad scaled median
+ *      absolute deviations from the median) and computes min, median, mean,
+ *      p95, p99, max and standard deviation of the rest.
+ * 3.Writes every result as JSON and CSV for regression tracking.
+ *
+ * The body is timed with a wall clock around the call, unless it returns a
+ * number, which is then taken as the duration of that repetition in seconds;
+ * this lets a body do untimed setup or report a device side time.
+ *
+ * Every option can be overridden from the environment with from_env():
+ * XCL_BENCH_WARMUP, XCL_BENCH_REPS, XCL_BENCH_OUTLIER_MAD, XCL_BENCH_JSON
+ * and XCL_BENCH_CSV (output file names).
+ */
+struct bench_options {
+    int warmup;
+    int repetitions;
+    double outlier_mad; // 0 keeps every sample
+    std::string json_file;
+    std::string csv_file;
+
+    bench_options() : warmup(1), repetitions(5), outlier_mad(3.5) {}
+
+    bench_options& from_env() {
+        const char* value;
+        if ((value = getenv("XCL_BENCH_WARMUP")) != nullptr) warmup = std::max(0, atoi(value));
+        if ((value = getenv("XCL_BENCH_REPS")) != nullptr) repetitions = std::max(1, atoi(value));
+        if ((value = getenv("XCL_BENCH_OUTLIER_MAD")) != nullptr) outlier_mad = atof(value);
+        if ((value = getenv("XCL_BENCH_JSON")) != nullptr) json_file = value;
+        if ((value = getenv("XCL_BENCH_CSV")) != nullptr) csv_file = value;
+        return *this;
+    }
+};
+
+struct bench_stats {
+    size_t samples;
+    size_t rejected;
+    double min;
+    double median;
+    double mean;
+    double p95;
+    double p99;
+    double max;
+    double stddev;
+};
+
+struct bench_result {
+    std::string name;
+    // Amount of work done by one repetition, in units of unit * seconds,
+    // e.g. MB for "MB/s"; 0 when only the time matters
+    double work;
+    std::string unit;
+    std::vector<double> seconds; // every measured repetition, in order
+    bench_stats time;            // over the samples that were kept
+
+    double rate() const { return time.median > 0 ? work / time.median : 0; }
+    double best_rate() const { return time.min > 0 ? work / time.min : 0; }
+};
+
+// Percentile of sorted samples, interpolating between neighbours
+inline double bench_percentile(const std::vector<double>& sorted, double fraction) {
+    if (sorted.empty()) return 0;
+    double pos = fraction * (sorted.size() - 1);
+    size_t lo = static_cast<size_t>(pos);
+    size_t hi = std::min(lo + 1, sorted.size() - 1);
+    return sorted[lo] + (sorted[hi] - sorted[lo]) * (pos - lo);
+}
+
+inline bench_stats bench_compute_stats(const std::vector<double>& samples, double outlier_mad) {
+    std::vector<double> sorted(samples);
+    std::sort(sorted.begin(), sorted.end());
+    double median = bench_percentile(sorted, 0.5);
+
+    if (outlier_mad > 0 && sorted.size() > 2) {
+        std::vector<double> deviation;
+        for (double s : sorted) deviation.push_back(std::fabs(s - median));
+        std::sort(deviation.begin(), deviation.end());
+        // 1.4826 scales the MAD to a standard deviation for normal data
+        double limit = outlier_mad * 1.4826 * bench_percentile(deviation, 0.5);
+        if (limit > 0) {
+            sorted.erase(std::remove_if(sorted.begin(), sorted.end(),
+                                        [&](double s) { return std::fabs(s - median) > limit; }),
+                         sorted.end());
+        }
+    }
+
+    bench_stats stats;
+    stats.samples = sorted.size();
+    stats.rejected = samples.size() - sorted.size();
+    stats.min = sorted.empty() ? 0 : sorted.front();
+    stats.max = sorted.empty() ? 0 : sorted.back();
+    stats.median = bench_percentile(sorted, 0.5);
+    stats.p95 = bench_percentile(sorted, 0.95);
+    stats.p99 = bench_percentile(sorted, 0.99);
+    double sum = 0, sum_sq = 0;
+    for (double s : sorted) sum += s;
+    stats.mean = sorted.empty() ? 0 : sum / sorted.size();
+    for (double s : sorted) sum_sq += (s - stats.mean) * (s - stats.mean);
+    stats.stddev = sorted.size() > 1 ? std::sqrt(sum_sq / (sorted.size() - 1)) : 0;
+    return stats;
+}
+
+class benchmark {
+   public:
+    explicit benchmark(const std::string& suite, const bench_options& options = bench_options())
+        : m_suite(suite), m_options(options) {}
+
+    const bench_options& options() const { return m_options; }
+    const std::deque<bench_result>& results() const { return m_results; }
+
+    // The returned result stays valid for the lifetime of the benchmark
+    template <typename F>
+    const bench_result& run(const std::string& name, F body, double work = 0, const std::string& unit = "") {
+        typedef typename std::is_void<decltype(body())>::type timed_here;
+        for (int i = 0; i < m_options.warmup; i++) measure(body, timed_here());
+
+        bench_result result;
+        result.name = name;
+        result.work = work;
+        result.unit = unit;
+        for (int i = 0; i < m_options.repetitions; i++) result.seconds.push_back(measure(body, timed_here()));
+        result.time = bench_compute_stats(result.seconds, m_options.outlier_mad);
+        m_results.push_back(result);
+        return m_results.back();
+    }
+
+    void write_json(std::ostream& out) const {
+        out << "{\n  \"suite\": \"" << escape(m_suite) << "\",\n  \"warmup\": " << m_options.warmup
+            << ",\n  \"repetitions\": " << m_options.repetitions << ",\n  \"results\": [";
+        for (size_t i = 0; i < m_results.size(); i++) {
+            const bench_result& r = m_results[i];
+            const bench_stats& t = r.time;
+            out << (i ? "," : "") << "\n    {\"name\": \"" << escape(r.name) << "\", \"unit\": \"" << escape(r.unit)
+                << "\", \"work\": " << r.work << ", \"samples\": " << t.samples << ", \"rejected\": " << t.rejected
+                << ",\n     \"seconds\": {\"min\": " << t.min << ", \"median\": " << t.median
+                << ", \"mean\": " << t.mean << ", \"p95\": " << t.p95 << ", \"p99\": " << t.p99
+                << ", \"max\": " << t.max << ", \"stddev\": " << t.stddev << "},\n     \"rate\": {\"median\": "
+                << r.rate() << ", \"best\": " << r.best_rate() << "}}";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+    void write_csv(std::ostream& out) const {
+        out << "suite,name,unit,work,samples,rejected,min_s,median_s,mean_s,p95_s,p99_s,max_s,stddev_s,"
+               "rate_median,rate_best\n";
+        for (auto& r : m_results) {
+            const bench_stats& t = r.time;
+            out << csv_field(m_suite) << "," << csv_field(r.name) << "," << csv_field(r.unit) << "," << r.work
+                << "," << t.samples << "," << t.rejected << "," << t.min << "," << t.median << "," << t.mean << ","
+                << t.p95 << "," << t.p99 << "," << t.max << "," << t.stddev << "," << r.rate() << ","
+                << r.best_rate() << "\n";
+        }
+    }
+
+    // Writes the files named in the options, if any
+    void save() const {
+        if (!m_options.json_file.empty()) {
+            std::ofstream out(m_options.json_file.c_str());
+            write_json(out);
+            std::cout << "Benchmark results written to " << m_options.json_file << std::endl;
+        }
+        if (!m_options.csv_file.empty()) {
+            std::ofstream out(m_options.csv_file.c_str());
+            write_csv(out);
+            std::cout << "Benchmark results written to " << m_options.csv_file << std::endl;
+        }
+    }
+
+    void print_summary() const {
+        printf("%-40s %12s %12s %12s %8s %7s\n", "Benchmark", "median", "p99", "rate", "stddev", "kept");
+        for (auto& r : m_results) {
+            const bench_stats& t = r.time;
+            printf("%-40s %9.3f ms %9.3f ms %12.4g %7.2f%% %3zu/%zu %s\n", r.name.c_str(), t.median * 1e3,
+                   t.p99 * 1e3, r.rate(), t.mean > 0 ? 100 * t.stddev / t.mean : 0.0, t.samples, r.seconds.size(),
+                   r.unit.c_str());
+        }
+    }
+
+   private:
+    template <typename F>
+    static double measure(F& body, std::true_type) {
+        auto start = std::chrono::high_resolution_clock::now();
+        body();
+        return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    template <typename F>
+    static double measure(F& body, std::false_type) {
+        return static_cast<double>(body());
+    }
+
+    static std::string escape(const std::string& s) {
+        std::string out;
+        for (char c : s) {
+            if (c == '"' || c == '\\') out += '\\';
+            out += c;
+        }
+        return out;
+    }
+
+    static std::string csv_field(const std::string& s) {
+        if (s.find_first_of(",\"") == std::string::npos) return s;
+        std::string out = "\"";
+        for (char c : s) out += c == '"' ? std::string("\"\"") : std::string(1, c);
+        return out + "\"";
+    }
+
+    std::string m_suite;
+    bench_options m_options;
+    // A deque so that references handed out by run() are never moved
+    std::deque<bench_result> m_results;
+};
+
+} // namespace xcl
+
+#endif
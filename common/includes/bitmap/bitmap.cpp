@@ -13,14 +13,156 @@
 * License for the specific language governing permissions and limitations
 * under the License.
 */
+#include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <vector>
 
 #include "bitmap.h"
+#include "pixel_pack.h"
+
+namespace {
+
+const unsigned int coreHeaderSize = 14;
+const unsigned int infoHeaderSize = 40;
+
+// BMP headers are little endian and not aligned
+unsigned int readLE(const unsigned char* p, int bytes) {
+    unsigned int value = 0;
+    for (int i = bytes - 1; i >= 0; i--) value = (value << 8) | p[i];
+    return value;
+}
+
+void writeLE(unsigned char* p, unsigned int value, int bytes) {
+    for (int i = 0; i < bytes; i++) p[i] = (value >> (8 * i)) & 0xff;
+}
+
+// writev() everything in iov, however many calls and partial writes it takes
+bool writeAll(int fd, std::vector<iovec>& iov) {
+    size_t first = 0;
+    while (first < iov.size()) {
+        if (iov[first].iov_len == 0) {
+            first++;
+            continue;
+        }
+        int count = std::min<size_t>(iov.size() - first, IOV_MAX);
+        ssize_t written = writev(fd, &iov[first], count);
+        if (written < 0 && errno == EINTR) continue;
+        // Nothing written while bytes are left would loop forever
+        if (written <= 0) return false;
+        // Skip what was written, possibly stopping inside an entry
+        while (first < iov.size() && (size_t)written >= iov[first].iov_len) {
+            written -= iov[first].iov_len;
+            first++;
+        }
+        if (first < iov.size()) {
+            iov[first].iov_base = (char*)iov[first].iov_base + written;
+            iov[first].iov_len -= written;
+        }
+    }
+    return true;
+}
+
+// pread() all of bytes, however many calls it takes
+bool readAll(int fd, unsigned char* dst, size_t bytes, off_t offset) {
+    while (bytes) {
+        ssize_t n = pread(fd, dst, bytes, offset);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        dst += n;
+        bytes -= n;
+        offset += n;
+    }
+    return true;
+}
+
+// preadv() everything in iov from offset on, however many calls it takes
+bool readAll(int fd, std::vector<iovec>& iov, off_t offset) {
+    size_t first = 0;
+    while (first < iov.size()) {
+        int count = std::min<size_t>(iov.size() - first, IOV_MAX);
+        ssize_t n = preadv(fd, &iov[first], count, offset);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        offset += n;
+        while (first < iov.size() && (size_t)n >= iov[first].iov_len) {
+            n -= iov[first].iov_len;
+            first++;
+        }
+        if (first < iov.size()) {
+            iov[first].iov_base = (char*)iov[first].iov_base + n;
+            iov[first].iov_len -= n;
+        }
+    }
+    return true;
+}
+
+// Calls body(i) for i in [0, count) on up to threads threads, the calling
+// thread included; the next free thread takes the next index
+template <typename F>
+void parallelFor(size_t count, unsigned threads, F body) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::max<size_t>(1, std::min<size_t>(threads, count));
+    std::atomic<size_t> next(0);
+    auto work = [&] {
+        for (size_t i = next++; i < count; i = next++) body(i);
+    };
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < threads; t++) workers.emplace_back(work);
+    work();
+    for (auto& worker : workers) worker.join();
+}
+
+// Where and how the pixels of a BMP file are stored
+struct Layout {
+    unsigned int offsetOfImage;
+    int width;
+    int height;
+    int bytesPerPixel;
+    size_t stride;
+    bool bottomUp;
+};
+
+// Checks the first coreHeaderSize + infoHeaderSize bytes of a fileSize byte
+// BMP file; returns why it cannot be read, or nullptr
+const char* parseHeader(const unsigned char* header, size_t fileSize, Layout& layout) {
+    const unsigned char* dibHeader = header + coreHeaderSize;
+    layout.offsetOfImage = readLE(header + 10, 4);
+    unsigned int sizeOfDIB = readLE(dibHeader, 4);
+    int rawHeight = (int)readLE(dibHeader + 8, 4);
+    layout.width = (int)readLE(dibHeader + 4, 4);
+    layout.height = rawHeight < 0 ? -rawHeight : rawHeight;
+    layout.bottomUp = rawHeight > 0;
+    int planes = readLE(dibHeader + 12, 2);
+    int depth = readLE(dibHeader + 14, 2);
+    unsigned int compression = readLE(dibHeader + 16, 4);
+    layout.bytesPerPixel = depth / 8;
+    layout.stride = 0;
+
+    if (header[0] != 'B' || header[1] != 'M') return "is not a BMP file";
+    if (sizeOfDIB < infoHeaderSize || layout.offsetOfImage < coreHeaderSize + sizeOfDIB ||
+        layout.offsetOfImage > fileSize)
+        return "has an unsupported or corrupt header";
+    if (planes != 1 || (depth != 24 && depth != 32)) return "is not a 24 or 32 bit BMP";
+    if (compression != 0 && !(compression == 3 && depth == 32)) return "is compressed";
+    if (layout.width <= 0 || layout.height <= 0 || rawHeight == INT_MIN) return "has an invalid size";
+    layout.stride = bitmapRowStride(layout.width, layout.bytesPerPixel);
+    if (layout.stride * layout.height > fileSize - layout.offsetOfImage) return "is truncated";
+    return nullptr;
+}
+
+} // namespace
 
 BitmapInterface::BitmapInterface(const char* f) : filename(f) {
     core = nullptr;
@@ -45,64 +187,437 @@ BitmapInterface::~BitmapInterface() {
 }
 
 bool BitmapInterface::readBitmapFile() {
-    // First, open the bitmap file
-    int fd;
-    unsigned int fileSize;
-
-    fd = open(filename, O_RDONLY);
-    if (fd < 0) {
+    BitmapView view;
+    if (!view.open(filename)) {
         std::cerr << "Cannot read image file " << filename << std::endl;
         return false;
     }
+    // Pixels are kept as 3 bytes, 32 bit files would be read as garbage
+    if (view.getBytesPerPixel() != 3) {
+        std::cerr << filename << " is not a 24 bit BMP file" << std::endl;
+        return false;
+    }
+    const unsigned char* file = view.data();
 
-    core = new char[14];
-    read(fd, core, 14);
-    magicNumber = (*(unsigned short*)(&(core[0])));
-    fileSize = (*(unsigned int*)(&(core[2])));
-    offsetOfImage = (*(unsigned int*)(&(core[10])));
+    core = new char[coreHeaderSize];
+    memcpy(core, file, coreHeaderSize);
+    magicNumber = readLE(file, 2);
+    fileSize = readLE(file + 2, 4);
+    offsetOfImage = readLE(file + 10, 4);
 
-    // Just read in the DIB, but don't process it
-    sizeOfDIB = offsetOfImage - 14;
+    // Keep the DIB as is, it is written back unchanged
+    sizeOfDIB = offsetOfImage - coreHeaderSize;
     dib = new char[sizeOfDIB];
-    read(fd, dib, sizeOfDIB);
+    memcpy(dib, file + coreHeaderSize, sizeOfDIB);
 
-    width = (*(int*)(&(dib[4])));
-    height = (*(int*)(&(dib[8])));
+    width = view.getWidth();
+    height = view.getHeight();
 
-    sizeOfImage = fileSize - 14 - sizeOfDIB;
+    sizeOfImage = std::min<size_t>(fileSize, view.size()) - coreHeaderSize - sizeOfDIB;
     int numPixels = sizeOfImage / 3; // RGB
 
     image = new int[numPixels];
 
-    for (int i = 0; i < numPixels; ++i) {
-        // Use an integer for every pixel even though we might not need that
-        //  much space (padding 0 bits in the rest of the integer)
-        image[i] = 0;
-        read(fd, &(image[i]), 3);
-    }
+    // Use an integer for every pixel even though we might not need that
+    //  much space (padding 0 bits in the rest of the integer)
+    xcl::rgb24_to_rgba32(reinterpret_cast<uint32_t*>(image), view.pixelData(), numPixels);
 
     return true;
 }
 
 bool BitmapInterface::writeBitmapFile(int* otherImage) {
     int fd;
-    fd = open("output.bmp", O_WRONLY | O_CREAT, 0644);
+    fd = open("output.bmp", O_WRONLY | O_CREAT | O_TRUNC, 0644);
 
     if (fd < 0) {
         std::cerr << "Cannot open output.bmp for writing!" << std::endl;
         return false;
     }
 
-    write(fd, core, 14);
-    write(fd, dib, sizeOfDIB);
-
     int numPixels = sizeOfImage / 3;
 
     int* outputImage = otherImage != nullptr ? otherImage : image;
 
-    for (int i = 0; i < numPixels; ++i) {
-        write(fd, &(outputImage[i]), 3);
+    // Pack the pixels back to 3 bytes and write everything at once
+    std::vector<unsigned char> pixels(numPixels * 3);
+    xcl::rgba32_to_rgb24(pixels.data(), reinterpret_cast<const uint32_t*>(outputImage), numPixels);
+    std::vector<iovec> iov = {{core, coreHeaderSize}, {dib, (size_t)sizeOfDIB}, {pixels.data(), pixels.size()}};
+    bool ok = writeAll(fd, iov);
+    close(fd);
+
+    if (!ok) std::cerr << "Cannot write output.bmp!" << std::endl;
+    return ok;
+}
+
+BitmapView::BitmapView() {
+    fd = -1;
+    base = nullptr;
+    mappedSize = 0;
+
+    offsetOfImage = 0;
+    width = 0;
+    height = 0;
+    bytesPerPixel = 0;
+    stride = 0;
+    bottomUp = true;
+}
+
+BitmapView::~BitmapView() {
+    close();
+}
+
+bool BitmapView::open(const char* filename) {
+    close();
+
+    fd = ::open(filename, O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Cannot open image file " << filename << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < coreHeaderSize + infoHeaderSize) {
+        std::cerr << filename << " is too small to be a BMP file" << std::endl;
+        close();
+        return false;
+    }
+    mappedSize = st.st_size;
+    void* mapping = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Cannot map image file " << filename << std::endl;
+        mappedSize = 0;
+        close();
+        return false;
+    }
+    base = static_cast<unsigned char*>(mapping);
+    // Pixels are read front to back
+    madvise(mapping, mappedSize, MADV_SEQUENTIAL);
+
+    Layout layout;
+    const char* error = parseHeader(base, mappedSize, layout);
+    offsetOfImage = layout.offsetOfImage;
+    width = layout.width;
+    height = layout.height;
+    bytesPerPixel = layout.bytesPerPixel;
+    stride = layout.stride;
+    bottomUp = layout.bottomUp;
+    if (error != nullptr) {
+        std::cerr << filename << " " << error << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void BitmapView::close() {
+    if (base != nullptr) munmap(base, mappedSize);
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+    base = nullptr;
+    mappedSize = 0;
+}
+
+BitmapBandReader::BitmapBandReader() {
+    fd = -1;
+    offsetOfImage = 0;
+    width = 0;
+    height = 0;
+    bytesPerPixel = 0;
+    stride = 0;
+    bottomUp = true;
+    rowsPerBand = 0;
+    bands = 0;
+    bufferBytes = 0;
+    handedOut = 0;
+    nextBand = 0;
+    stopping = false;
+    failed = false;
+}
+
+BitmapBandReader::~BitmapBandReader() {
+    close();
+}
+
+bool BitmapBandReader::open(const char* filename, int rows, int depth) {
+    close();
+    if (rows <= 0 || depth <= 0) {
+        std::cerr << "Bands need at least one row and one buffer" << std::endl;
+        return false;
     }
 
+    fd = ::open(filename, O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Cannot open image file " << filename << std::endl;
+        return false;
+    }
+    struct stat st;
+    unsigned char header[coreHeaderSize + infoHeaderSize];
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(header) || !readAll(fd, header, sizeof(header), 0)) {
+        std::cerr << filename << " is too small to be a BMP file" << std::endl;
+        close();
+        return false;
+    }
+    Layout layout;
+    const char* error = parseHeader(header, st.st_size, layout);
+    if (error != nullptr) {
+        std::cerr << filename << " " << error << std::endl;
+        close();
+        return false;
+    }
+    offsetOfImage = layout.offsetOfImage;
+    width = layout.width;
+    height = layout.height;
+    bytesPerPixel = layout.bytesPerPixel;
+    stride = layout.stride;
+    bottomUp = layout.bottomUp;
+
+    rowsPerBand = std::min(rows, height);
+    bands = (height + rowsPerBand - 1) / rowsPerBand;
+    size_t pageSize = sysconf(_SC_PAGESIZE);
+    bufferBytes = (rowsPerBand * stride + pageSize - 1) / pageSize * pageSize;
+    for (int slot = 0; slot < std::min(depth, bands); slot++) {
+        void* buffer = nullptr;
+        if (posix_memalign(&buffer, pageSize, bufferBytes) != 0) {
+            std::cerr << "Cannot allocate the band buffers of " << filename << std::endl;
+            close();
+            return false;
+        }
+        buffers.push_back(static_cast<unsigned char*>(buffer));
+        freeSlots.push_back(slot);
+    }
+
+    reader = std::thread(&BitmapBandReader::readBands, this);
+    return true;
+}
+
+void BitmapBandReader::readBands() {
+    for (int index = 0; index < bands; index++) {
+        int slot;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [this] { return stopping || !freeSlots.empty(); });
+            if (stopping) return;
+            slot = freeSlots.front();
+            freeSlots.pop_front();
+        }
+
+        Band band;
+        band.index = index;
+        band.slot = slot;
+        band.firstRow = index * rowsPerBand;
+        band.rows = std::min(rowsPerBand, height - band.firstRow);
+        band.stride = stride;
+        band.bottomUp = bottomUp;
+        band.data = buffers[slot];
+        band.bytes = band.rows * stride;
+        // Bottom-up files store the top band last
+        int firstStoredRow = bottomUp ? height - band.firstRow - band.rows : band.firstRow;
+        bool ok = readAll(fd, band.data, band.bytes, offsetOfImage + (off_t)firstStoredRow * stride);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (ok)
+            ready.push_back(band);
+        else
+            failed = true;
+        changed.notify_all();
+        if (!ok) return;
+    }
+}
+
+bool BitmapBandReader::next(Band& band) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (nextBand >= bands) return false;
+    changed.wait(lock, [this] { return !ready.empty() || failed || handedOut == (int)buffers.size(); });
+    if (ready.empty()) {
+        if (failed)
+            std::cerr << "Cannot read band " << nextBand << " of the image" << std::endl;
+        else
+            std::cerr << "Every band buffer is in use, release a band before asking for the next one" << std::endl;
+        return false;
+    }
+    band = ready.front();
+    ready.pop_front();
+    handedOut++;
+    nextBand++;
     return true;
 }
+
+void BitmapBandReader::release(const Band& band) {
+    std::lock_guard<std::mutex> lock(mutex);
+    freeSlots.push_back(band.slot);
+    handedOut--;
+    changed.notify_all();
+}
+
+void BitmapBandReader::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    if (reader.joinable()) reader.join();
+
+    for (unsigned char* buffer : buffers) free(buffer);
+    buffers.clear();
+    freeSlots.clear();
+    ready.clear();
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+    bands = 0;
+    handedOut = 0;
+    nextBand = 0;
+    stopping = false;
+    failed = false;
+}
+
+BitmapBatch::BitmapBatch() {
+    base = nullptr;
+    used = 0;
+    capacity = 0;
+}
+
+BitmapBatch::~BitmapBatch() {
+    free(base);
+}
+
+bool BitmapBatch::load(const std::vector<std::string>& files, unsigned threads) {
+    entries.assign(files.size(), Entry());
+    std::vector<Layout> layouts(files.size());
+    std::vector<const char*> errors(files.size(), nullptr);
+    std::vector<int> fds(files.size(), -1);
+
+    // Files stay open between the two passes, as far as half the descriptor
+    // limit allows; the others are opened again for their pixels
+    struct rlimit limit;
+    size_t keepOpen = getrlimit(RLIMIT_NOFILE, &limit) == 0 ? limit.rlim_cur / 2 : 0;
+
+    // Headers first, they give the size and place of every image
+    parallelFor(files.size(), threads, [&](size_t i) {
+        unsigned char header[coreHeaderSize + infoHeaderSize];
+        struct stat st;
+        int fd = ::open(files[i].c_str(), O_RDONLY);
+        if (fd < 0) {
+            errors[i] = "cannot be opened";
+            return;
+        }
+        if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(header) || !readAll(fd, header, sizeof(header), 0))
+            errors[i] = "is too small to be a BMP file";
+        else
+            errors[i] = parseHeader(header, st.st_size, layouts[i]);
+        if (errors[i] == nullptr && i < keepOpen)
+            fds[i] = fd;
+        else
+            ::close(fd);
+    });
+
+    size_t total = 0;
+    for (size_t i = 0; i < files.size(); i++) {
+        if (errors[i] != nullptr) continue;
+        Entry& e = entries[i];
+        e.offset = total;
+        e.width = layouts[i].width;
+        e.height = layouts[i].height;
+        e.bytesPerPixel = layouts[i].bytesPerPixel;
+        e.stride = layouts[i].stride;
+        e.bytes = e.stride * e.height;
+        total += (e.bytes + 63) & ~(size_t)63;
+    }
+    size_t pageSize = sysconf(_SC_PAGESIZE);
+    used = (total + pageSize - 1) / pageSize * pageSize;
+    if (used > capacity) {
+        free(base);
+        base = nullptr;
+        capacity = 0;
+        void* arena = nullptr;
+        if (posix_memalign(&arena, pageSize, used) != 0) {
+            std::cerr << "Cannot allocate " << used << " bytes for " << files.size() << " images" << std::endl;
+            for (int fd : fds) {
+                if (fd >= 0) ::close(fd);
+            }
+            entries.clear();
+            used = 0;
+            return false;
+        }
+        base = static_cast<unsigned char*>(arena);
+        capacity = used;
+    }
+
+    // Then the pixels, straight into the arena and top-down: a bottom-up
+    // file is read with one iovec per row, last row first
+    parallelFor(files.size(), threads, [&](size_t i) {
+        if (errors[i] != nullptr) return;
+        const Entry& e = entries[i];
+        int fd = fds[i] >= 0 ? fds[i] : ::open(files[i].c_str(), O_RDONLY);
+        if (fd < 0) {
+            errors[i] = "cannot be opened";
+            return;
+        }
+        std::vector<iovec> iov;
+        if (layouts[i].bottomUp) {
+            iov.reserve(e.height);
+            for (int y = e.height - 1; y >= 0; y--) iov.push_back({base + e.offset + y * e.stride, e.stride});
+        } else {
+            iov.push_back({base + e.offset, e.bytes});
+        }
+        if (!readAll(fd, iov, layouts[i].offsetOfImage)) errors[i] = "is truncated";
+        ::close(fd);
+    });
+
+    bool ok = true;
+    for (size_t i = 0; i < files.size(); i++) {
+        if (errors[i] == nullptr) continue;
+        std::cerr << files[i] << " " << errors[i] << std::endl;
+        entries[i] = Entry();
+        ok = false;
+    }
+    return ok;
+}
+
+bool writeBitmap(
+    const char* filename, int width, int height, const unsigned char* pixels, size_t srcStride, bool topDown) {
+    size_t rowBytes = (size_t)width * 3;
+    size_t stride = bitmapRowStride(width, 3);
+    size_t imageSize = stride * height;
+    if (width <= 0 || height <= 0 || srcStride < rowBytes || imageSize > UINT_MAX - 54) {
+        std::cerr << "Cannot write a " << width << "x" << height << " BMP" << std::endl;
+        return false;
+    }
+
+    unsigned char header[coreHeaderSize + infoHeaderSize] = {0};
+    header[0] = 'B';
+    header[1] = 'M';
+    writeLE(header + 2, sizeof(header) + imageSize, 4);
+    writeLE(header + 10, sizeof(header), 4);
+    writeLE(header + 14, infoHeaderSize, 4);
+    writeLE(header + 18, width, 4);
+    writeLE(header + 22, topDown ? -height : height, 4);
+    writeLE(header + 26, 1, 2);
+    writeLE(header + 28, 24, 2);
+    writeLE(header + 34, imageSize, 4);
+    writeLE(header + 38, 2835, 4); // 72 DPI
+    writeLE(header + 42, 2835, 4);
+
+    static const unsigned char padding[3] = {0};
+    std::vector<iovec> iov;
+    iov.push_back({header, sizeof(header)});
+    if (topDown && srcStride == stride) {
+        // Already in file layout
+        iov.push_back({(void*)pixels, imageSize});
+    } else {
+        iov.reserve(1 + 2 * height);
+        for (int i = 0; i < height; i++) {
+            int y = topDown ? i : height - 1 - i;
+            iov.push_back({(void*)(pixels + y * srcStride), rowBytes});
+            if (stride != rowBytes) iov.push_back({(void*)padding, stride - rowBytes});
+        }
+    }
+
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "Cannot open " << filename << " for writing!" << std::endl;
+        return false;
+    }
+    bool ok = writeAll(fd, iov);
+    ok = close(fd) == 0 && ok;
+    if (!ok) std::cerr << "Cannot write " << filename << std::endl;
+    return ok;
+}
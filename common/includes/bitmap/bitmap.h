@@ -16,8 +16,16 @@
 #ifndef BITMAP_DOT_H
 #define BITMAP_DOT_H
 
+#include <stddef.h>
 #include <stdlib.h>
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 class BitmapInterface {
    private:
     char* core;
@@ -50,4 +58,190 @@ class BitmapInterface {
     inline int getWidth() { return width; }
 };
 
+// Read-only, memory mapped view of an uncompressed 24 or 32 bit BMP file.
+// Nothing is copied: row(y) points straight into the mapping. Rows are
+// rowStride() bytes apart because each one is padded to a multiple of 4
+// bytes, and rows are numbered from the top of the image whichever order
+// the file stores them in. Pixels are in file order, B G R [A].
+class BitmapView {
+   private:
+    int fd;
+    unsigned char* base;
+    size_t mappedSize;
+
+    unsigned int offsetOfImage;
+    int width;
+    int height;
+    int bytesPerPixel;
+    size_t stride;
+    bool bottomUp;
+
+   public:
+    BitmapView();
+    ~BitmapView();
+
+    // Maps and validates the file, prints the reason and returns false if
+    // it is not a BMP this view can read
+    bool open(const char* filename);
+    void close();
+
+    inline bool isOpen() const { return base != nullptr; }
+    inline int getWidth() const { return width; }
+    inline int getHeight() const { return height; }
+    inline int getBytesPerPixel() const { return bytesPerPixel; }
+    inline size_t rowStride() const { return stride; }
+    inline bool isBottomUp() const { return bottomUp; }
+
+    // Rows as stored in the file, first stored row first
+    inline const unsigned char* pixelData() const { return base + offsetOfImage; }
+    inline const unsigned char* row(int y) const {
+        return pixelData() + (bottomUp ? height - 1 - y : y) * stride;
+    }
+    inline const unsigned char* pixel(int x, int y) const { return row(y) + x * bytesPerPixel; }
+
+    // Whole file, headers included
+    inline const unsigned char* data() const { return base; }
+    inline size_t size() const { return mappedSize; }
+};
+
+// Streams an uncompressed 24 or 32 bit BMP file as bands of rowsPerBand
+// rows, top band first. A background thread reads the bands with pread()
+// into a ring of depth page aligned buffers, so at most depth bands are in
+// memory whatever the image size, and the next bands are read from disk
+// while the caller works on the current one.
+//
+// next() hands out the oldest band read so far; the caller gives its buffer
+// back with release() once it is done with it, e.g. after the kernel that
+// reads it has finished. Several bands can be held at a time, e.g. one
+// being processed by the device and one being synced to it, as long as one
+// buffer is left for the reader. The ring buffers never move, so each can be
+// wrapped once as a host pointer buffer (buffer(slot), bufferSize()) and
+// reused for every band that lands in it.
+class BitmapBandReader {
+   public:
+    struct Band {
+        int index;
+        int slot;     // ring buffer holding the band
+        int firstRow; // counted from the top of the image
+        int rows;
+        size_t stride;
+        bool bottomUp; // rows are in file order, bottom row first
+        unsigned char* data;
+        size_t bytes;
+
+        inline const unsigned char* row(int y) const {
+            return data + (bottomUp ? rows - 1 - (y - firstRow) : y - firstRow) * stride;
+        }
+    };
+
+    BitmapBandReader();
+    ~BitmapBandReader();
+    BitmapBandReader(const BitmapBandReader&) = delete;
+    BitmapBandReader& operator=(const BitmapBandReader&) = delete;
+
+    // Validates the file and starts reading, prints the reason and returns
+    // false if it is not a BMP this reader can stream
+    bool open(const char* filename, int rowsPerBand, int depth = 3);
+    void close();
+
+    // Waits for the next band; false once every band was handed out, on a
+    // read error, or if the caller holds every buffer of the ring
+    bool next(Band& band);
+    void release(const Band& band);
+
+    inline int getWidth() const { return width; }
+    inline int getHeight() const { return height; }
+    inline int getBytesPerPixel() const { return bytesPerPixel; }
+    inline size_t rowStride() const { return stride; }
+    inline int numBands() const { return bands; }
+    inline int ringDepth() const { return (int)buffers.size(); }
+    inline unsigned char* buffer(int slot) const { return buffers[slot]; }
+    inline size_t bufferSize() const { return bufferBytes; }
+
+   private:
+    void readBands();
+
+    int fd;
+    unsigned int offsetOfImage;
+    int width;
+    int height;
+    int bytesPerPixel;
+    size_t stride;
+    bool bottomUp;
+    int rowsPerBand;
+    int bands;
+    size_t bufferBytes;
+    std::vector<unsigned char*> buffers;
+
+    std::thread reader;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<int> freeSlots;
+    std::deque<Band> ready;
+    int handedOut; // bands returned by next() and not released yet
+    int nextBand;  // next band next() returns
+    bool stopping;
+    bool failed;
+};
+
+// Loads a batch of uncompressed 24 or 32 bit BMP files into one page
+// aligned arena, decoding them on a pool of threads. Each image starts on a
+// 64 byte boundary, with its rows top-down and stride bytes apart whatever
+// order the file stores them in; entry(i) gives where and what shape image
+// i is. The arena is a whole number of pages, so the batch can be imported
+// as a single host pointer buffer and moved to the device in one transfer.
+// The arena is kept and reused by the next load() when it is big enough.
+class BitmapBatch {
+   public:
+    struct Entry {
+        size_t offset; // from arena()
+        size_t bytes;  // 0 if the file could not be loaded
+        int width;
+        int height;
+        int bytesPerPixel;
+        size_t stride;
+    };
+
+    BitmapBatch();
+    ~BitmapBatch();
+    BitmapBatch(const BitmapBatch&) = delete;
+    BitmapBatch& operator=(const BitmapBatch&) = delete;
+
+    // Loads the files with threads workers, 0 for every hardware thread.
+    // Returns false if any file could not be loaded; the reason is printed
+    // and its entry is left empty, the other images are still loaded.
+    bool load(const std::vector<std::string>& files, unsigned threads = 0);
+
+    inline size_t size() const { return entries.size(); }
+    inline const Entry& entry(size_t i) const { return entries[i]; }
+    inline unsigned char* image(size_t i) const { return base + entries[i].offset; }
+
+    inline unsigned char* arena() const { return base; }
+    inline size_t arenaSize() const { return used; } // rounded up to a page
+    inline size_t arenaCapacity() const { return capacity; }
+
+   private:
+    unsigned char* base;
+    size_t used;
+    size_t capacity;
+    std::vector<Entry> entries;
+};
+
+// Writes a 24 bit uncompressed BMP. Row y of the image (from the top) is the
+// width * 3 bytes at pixels + y * srcStride, B G R order. Headers, rows and
+// row padding are handed to the kernel with writev(). A top-down file whose
+// srcStride already is the padded BMP row goes out in a single call; the
+// default bottom-up file takes one iovec per row.
+bool writeBitmap(const char* filename,
+                 int width,
+                 int height,
+                 const unsigned char* pixels,
+                 size_t srcStride,
+                 bool topDown = false);
+
+// Size of a padded BMP row
+inline size_t bitmapRowStride(int width, int bytesPerPixel) {
+    return ((size_t)width * bytesPerPixel + 3) & ~(size_t)3;
+}
+
 #endif
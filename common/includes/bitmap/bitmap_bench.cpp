@@ -0,0 +1,201 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+
+/********************************************************************************************
+ * Description:
+ * Host only throughput benchmark of the BMP readers and writers.
+ * common/data/xilinx_img.bmp is scaled up (nearest neighbour, 3840x2160 by
+ * default) and written to bitmap_bench.bmp, then the file is read and
+ * written back (bitmap_bench_out.bmp, output.bmp) with
+ *   - the previous per-pixel read()/write() loops of BitmapInterface,
+ *   - BitmapInterface::readBitmapFile()/writeBitmapFile(),
+ *   - BitmapView, touching every pixel, and writeBitmap(),
+ *   - BitmapBandReader, 64 rows at a time, touching every pixel.
+ * It then cuts the image into 128x128 tiles, one file each under
+ * bitmap_bench_tiles/, and loads them all into one buffer with readbmp() one
+ * after the other and with BitmapBatch.
+ * The file stays in the page cache, so the read numbers are the cost of
+ * getting the pixels into the process rather than disk throughput.
+ *
+ * Build and run:
+ *   g++ -O2 -std=c++1y -pthread -I../bench -I../pixel_pack -I../simplebmp bitmap_bench.cpp bitmap.cpp \
+ *       ../pixel_pack/pixel_pack.cpp ../simplebmp/simplebmp.cpp -o bitmap_bench
+ *   ./bitmap_bench [path to xilinx_img.bmp] [width] [height]
+ *
+ * Repetitions and JSON/CSV output follow the XCL_BENCH_* variables of bench.h.
+ ******************************************************************************************/
+
+#include "bench.h"
+#include "bitmap.h"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "simplebmp.h"
+
+// The loops BitmapInterface used before BitmapView: one syscall per pixel
+static unsigned int legacyRead(const char* filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return 0;
+    char core[14];
+    read(fd, core, 14);
+    unsigned int fileSize = (*(unsigned int*)(&(core[2])));
+    unsigned int offsetOfImage = (*(unsigned int*)(&(core[10])));
+    std::vector<char> dib(offsetOfImage - 14);
+    read(fd, dib.data(), dib.size());
+
+    int numPixels = (fileSize - offsetOfImage) / 3;
+    std::vector<int> image(numPixels);
+    unsigned int sum = 0;
+    for (int i = 0; i < numPixels; ++i) {
+        image[i] = 0;
+        read(fd, &(image[i]), 3);
+        sum += image[i];
+    }
+    close(fd);
+    return sum;
+}
+
+static void legacyWrite(const char* filename, const BitmapView& view) {
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return;
+    write(fd, view.data(), 54);
+    for (int y = view.getHeight() - 1; y >= 0; y--) {
+        for (int x = 0; x < view.getWidth(); x++) write(fd, view.pixel(x, y), 3);
+    }
+    close(fd);
+}
+
+int main(int argc, char* argv[]) {
+    const char* source = argc > 1 ? argv[1] : "../../data/xilinx_img.bmp";
+    int width = argc > 2 ? atoi(argv[2]) : 3840;
+    int height = argc > 3 ? atoi(argv[3]) : 2160;
+    if (width <= 0 || height <= 0) {
+        printf("Usage: %s [path to xilinx_img.bmp] [width] [height]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    BitmapView input;
+    if (!input.open(source) || input.getBytesPerPixel() != 3) {
+        printf("Cannot use %s as the source image\n", source);
+        return EXIT_FAILURE;
+    }
+    size_t srcStride = (size_t)width * 3;
+    std::vector<unsigned char> scaled(srcStride * height);
+    for (int y = 0; y < height; y++) {
+        const unsigned char* src = input.row((long)y * input.getHeight() / height);
+        unsigned char* dst = &scaled[y * srcStride];
+        for (int x = 0; x < width; x++) {
+            const unsigned char* p = src + (long)x * input.getWidth() / width * 3;
+            dst[3 * x] = p[0];
+            dst[3 * x + 1] = p[1];
+            dst[3 * x + 2] = p[2];
+        }
+    }
+    input.close();
+
+    const char* file = "bitmap_bench.bmp";
+    if (!writeBitmap(file, width, height, scaled.data(), srcStride)) return EXIT_FAILURE;
+    double megabytes = (double)bitmapRowStride(width, 3) * height / 1e6;
+    printf("%dx%d image, %.1f MB of pixels\n", width, height, megabytes);
+
+    xcl::bench_options options;
+    options.warmup = 1;
+    options.repetitions = 3;
+    xcl::benchmark bench("bitmap", options.from_env());
+    volatile unsigned int sink = 0;
+
+    bench.run("read, per-pixel read()", [&] { sink = sink + legacyRead(file); }, megabytes, "MB/s");
+    bench.run("read, BitmapInterface",
+              [&] {
+                  BitmapInterface bmp(file);
+                  bmp.readBitmapFile();
+                  sink = sink + bmp.bitmap()[bmp.numPixels() - 1];
+              },
+              megabytes, "MB/s");
+    bench.run("read, BitmapView",
+              [&] {
+                  BitmapView view;
+                  view.open(file);
+                  unsigned int sum = 0;
+                  for (int y = 0; y < view.getHeight(); y++) {
+                      const unsigned char* row = view.row(y);
+                      for (int x = 0; x < view.getWidth() * 3; x++) sum += row[x];
+                  }
+                  sink = sink + sum;
+              },
+              megabytes, "MB/s");
+    bench.run("read, BitmapBandReader",
+              [&] {
+                  BitmapBandReader reader;
+                  reader.open(file, 64);
+                  unsigned int sum = 0;
+                  BitmapBandReader::Band band;
+                  while (reader.next(band)) {
+                      for (size_t i = 0; i < band.bytes; i++) sum += band.data[i];
+                      reader.release(band);
+                  }
+                  sink = sink + sum;
+              },
+              megabytes, "MB/s");
+
+    BitmapView view;
+    view.open(file);
+    bench.run("write, per-pixel write()", [&] { legacyWrite("bitmap_bench_out.bmp", view); }, megabytes, "MB/s");
+    BitmapInterface bmp(file);
+    bmp.readBitmapFile();
+    bench.run("write, BitmapInterface", [&] { bmp.writeBitmapFile(); }, megabytes, "MB/s");
+    bench.run("write, writeBitmap",
+              [&] { writeBitmap("bitmap_bench_out.bmp", width, height, scaled.data(), srcStride); }, megabytes,
+              "MB/s");
+
+    const int tile = 128;
+    std::vector<std::string> tiles;
+    mkdir("bitmap_bench_tiles", 0755);
+    for (int y = 0; y + tile <= height; y += tile) {
+        for (int x = 0; x + tile <= width; x += tile) {
+            std::string name = "bitmap_bench_tiles/" + std::to_string(tiles.size()) + ".bmp";
+            if (!writeBitmap(name.c_str(), tile, tile, &scaled[y * srcStride + x * 3], srcStride)) return EXIT_FAILURE;
+            tiles.push_back(name);
+        }
+    }
+    printf("%zu tiles of %dx%d\n", tiles.size(), tile, tile);
+    // readbmp() gives one malloc()ed image at a time, which still has to be
+    // copied into a buffer to move the batch in one transfer
+    std::vector<unsigned char> staging(tiles.size() * tile * tile * 3);
+    bench.run("batch, readbmp + copy",
+              [&] {
+                  unsigned char* dst = staging.data();
+                  for (auto& name : tiles) {
+                      bmp_t bmp;
+                      if (readbmp(const_cast<char*>(name.c_str()), &bmp) != 0) continue;
+                      memcpy(dst, bmp.pixels, bmp.header.dibsize);
+                      dst += bmp.header.dibsize;
+                      free(bmp.pixels);
+                  }
+              },
+              tiles.size(), "images/s");
+    BitmapBatch batch;
+    bench.run("batch, BitmapBatch", [&] { batch.load(tiles); }, tiles.size(), "images/s");
+
+    bench.print_summary();
+    bench.save();
+    return EXIT_SUCCESS;
+}
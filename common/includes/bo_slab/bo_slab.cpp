@@ -0,0 +1,73 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+#include "bo_slab.h"
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace xcl {
+
+bo_slab::bo_slab(const xrt::device& device,
+                 xrt::memory_group grp,
+                 size_t slot_size,
+                 size_t slots,
+                 size_t alignment)
+    : m_slot_size(slot_size), m_slots(slots) {
+    if (slot_size == 0 || slots == 0 || alignment == 0 || (alignment & (alignment - 1)) != 0) {
+        printf("bo_slab: invalid geometry (slot %zu, slots %zu, alignment %zu)\n", slot_size, slots, alignment);
+        exit(EXIT_FAILURE);
+    }
+    m_stride = (slot_size + alignment - 1) & ~(alignment - 1);
+    m_parent = xrt::bo(device, m_stride * m_slots, grp);
+    m_base = m_parent.address();
+
+    // Hand out low slots first so consecutive commands touch neighbouring memory
+    m_free.resize(m_slots);
+    for (size_t i = 0; i < m_slots; i++) m_free[i] = static_cast<uint32_t>(m_slots - 1 - i);
+    m_used.assign(m_slots, false);
+}
+
+xrt::bo bo_slab::alloc() {
+    uint32_t slot;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_free.empty()) throw std::bad_alloc();
+        slot = m_free.back();
+        m_free.pop_back();
+        m_used[slot] = true;
+    }
+    return xrt::bo(m_parent, m_slot_size, slot * m_stride);
+}
+
+void bo_slab::free(const xrt::bo& bo) {
+    uint64_t offset = bo.address() - m_base;
+    size_t slot = offset / m_stride;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (bo.address() < m_base || offset % m_stride != 0 || slot >= m_slots || !m_used[slot]) {
+        printf("bo_slab: buffer at 0x%llx was not allocated from this slab\n", (unsigned long long)bo.address());
+        exit(EXIT_FAILURE);
+    }
+    m_used[slot] = false;
+    m_free.push_back(static_cast<uint32_t>(slot));
+}
+
+size_t bo_slab::available() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_free.size();
+}
+
+} // namespace xcl
@@ -0,0 +1,75 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+#ifndef BO_SLAB_H_
+#define BO_SLAB_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "experimental/xrt_bo.h"
+#include "experimental/xrt_device.h"
+
+namespace xcl {
+
+/*!
+ * Synopsis:
+ * 1.Allocates one large buffer object in a memory group up front.
+ * 2.Hands out fixed size, aligned sub-buffers of it (XRT sub-BOs) so that
+ *      small argument buffers do not each cost a driver allocation.
+ * 3.Keeps free slots on a stack, so alloc() and free() are O(1).
+ *
+ * Use one slab per memory group. Sub-buffers are synced, mapped and passed
+ * to kernels like any other xrt::bo. Return them with free() so their slot
+ * can be handed out again.
+ */
+class bo_slab {
+   public:
+    bo_slab(const xrt::device& device,
+            xrt::memory_group grp,
+            size_t slot_size,
+            size_t slots,
+            size_t alignment = 64);
+
+    bo_slab(const bo_slab&) = delete;
+    bo_slab& operator=(const bo_slab&) = delete;
+
+    // Returns a sub-buffer of slot_size bytes; throws std::bad_alloc when
+    // every slot is in use.
+    xrt::bo alloc();
+    void free(const xrt::bo& bo);
+
+    const xrt::bo& parent() const { return m_parent; }
+    size_t slot_size() const { return m_slot_size; }
+    size_t stride() const { return m_stride; }
+    size_t capacity() const { return m_slots; }
+    size_t available() const;
+
+   private:
+    xrt::bo m_parent;
+    uint64_t m_base;
+    size_t m_slot_size;
+    size_t m_stride;
+    size_t m_slots;
+    std::vector<uint32_t> m_free;
+    std::vector<bool> m_used;
+    mutable std::mutex m_mutex;
+};
+
+} // namespace xcl
+
+#endif
@@ -16,6 +16,7 @@
 #include "cmdlineparser.h"
 #include "logger.h"
 #include <assert.h>
+#include <cctype>
 #include <fstream>
 #include <iostream>
 #include <stdlib.h>
@@ -44,6 +45,93 @@ bool starts_with(const string& src, const string& sub) {
     return (src.find(sub) == 0);
 }
 
+// Upper bound on the number of values a sweep may expand to, so a range with
+// a typo in its step does not exhaust memory
+const size_t max_sweep_values = 65536;
+
+bool parse_size(const string& text, uint64_t& size) {
+    size_t pos = 0;
+    uint64_t value = 0;
+    while (pos < text.length() && std::isdigit(text[pos])) {
+        uint64_t digit = text[pos++] - '0';
+        if (value > (UINT64_MAX - digit) / 10) return false;
+        value = value * 10 + digit;
+    }
+    if (pos == 0) return false;
+
+    int shift = 0;
+    if (pos < text.length()) {
+        switch (std::toupper(text[pos])) {
+            case 'K':
+                shift = 10;
+                break;
+            case 'M':
+                shift = 20;
+                break;
+            case 'G':
+                shift = 30;
+                break;
+            case 'T':
+                shift = 40;
+                break;
+        }
+        if (shift) pos++;
+    }
+    if (pos < text.length() && std::toupper(text[pos]) == 'B') pos++;
+    if (pos != text.length() || value > (UINT64_MAX >> shift)) return false;
+
+    size = value << shift;
+    return true;
+}
+
+static bool parse_range(const string& text, std::vector<uint64_t>& values) {
+    std::vector<string> fields;
+    size_t start = 0, colon;
+    while ((colon = text.find(':', start)) != string::npos) {
+        fields.push_back(text.substr(start, colon - start));
+        start = colon + 1;
+    }
+    fields.push_back(text.substr(start));
+
+    uint64_t first, last, step = 2;
+    bool factor = true;
+    if (fields.size() > 3 || !parse_size(fields[0], first)) return false;
+    if (fields.size() == 1) {
+        values.push_back(first);
+        return true;
+    }
+    if (!parse_size(fields[1], last) || first > last) return false;
+    if (fields.size() == 3) {
+        string s = fields[2];
+        factor = !s.empty() && (s[0] == 'x' || s[0] == 'X' || s[0] == '*');
+        if (!s.empty() && (factor || s[0] == '+')) s = s.substr(1);
+        if (!parse_size(s, step) || step < (factor ? 2u : 1u)) return false;
+    }
+
+    for (uint64_t v = first; v <= last;) {
+        if (values.size() == max_sweep_values) return false;
+        values.push_back(v);
+        if (factor ? v > UINT64_MAX / step : v > UINT64_MAX - step) break;
+        v = factor ? v * step : v + step;
+    }
+    return true;
+}
+
+bool parse_sweep(const string& text, std::vector<uint64_t>& values) {
+    values.clear();
+    size_t start = 0;
+    while (start <= text.length()) {
+        size_t comma = text.find(',', start);
+        if (comma == string::npos) comma = text.length();
+        if (!parse_range(text.substr(start, comma - start), values)) {
+            values.clear();
+            return false;
+        }
+        start = comma + 1;
+    }
+    return true;
+}
+
 CmdLineParser::CmdLineParser() {
     // TODO Auto-generated constructor stub
     m_strDefaultKey = "";
@@ -300,6 +388,25 @@ double CmdLineParser::value_to_double(const char* key) {
     return atof(strVal.c_str());
 }
 
+uint64_t CmdLineParser::value_to_size(const char* key) {
+    string strVal = value(key);
+    uint64_t size;
+    if (!parse_size(strVal, size)) {
+        LogError("The value %s of %s is not a size", strVal.c_str(), key);
+        return 0;
+    }
+    return size;
+}
+
+std::vector<uint64_t> CmdLineParser::value_to_sweep(const char* key) {
+    string strVal = value(key);
+    std::vector<uint64_t> values;
+    if (!parse_sweep(strVal, values)) {
+        LogError("The value %s of %s is not a valid sweep", strVal.c_str(), key);
+    }
+    return values;
+}
+
 bool CmdLineParser::isValid(const char* key) {
     string strKey(key);
     if (!starts_with(strKey, "--")) strKey = "--" + strKey;
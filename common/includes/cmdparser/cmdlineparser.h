@@ -16,6 +16,7 @@
 #ifndef CMDLINEPARSER_H_
 #define CMDLINEPARSER_H_
 
+#include <cstdint>
 #include <map>
 #include <string>
 #include <vector>
@@ -25,6 +26,20 @@ namespace utils {
 
 bool is_file(const std::string& name);
 
+/*!
+ * Parses a size such as "4096", "64K", "256M" or "1G". Units are binary
+ * multiples, case insensitive, and may be followed by a B ("64KB").
+ */
+bool parse_size(const std::string& text, uint64_t& size);
+
+/*!
+ * Expands a sweep into the values it names, in order. A sweep is a comma
+ * separated list of sizes and ranges. A range is first:last[:step] where
+ * step is an increment ("+4K" or "4K") or a factor ("x2"); it defaults to
+ * x2. For example "4K:256M:x2", "10,100,1000" or "1M:4M:+1M,16M".
+ */
+bool parse_sweep(const std::string& text, std::vector<uint64_t>& values);
+
 /*!
  * Synopsis:
  * 1.Parses the command line passed in from the user and stores all enabled
@@ -78,6 +93,17 @@ class CmdLineParser {
 
     double value_to_double(const char* key);
 
+    /*!
+     * retrieve a size ("64K", "256M", "1G"), 0 if it can not be parsed
+     */
+    uint64_t value_to_size(const char* key);
+
+    /*!
+     * retrieve the values of a sweep ("4K:256M:x2", "10,100,1000"), empty if
+     * it can not be parsed
+     */
+    std::vector<uint64_t> value_to_sweep(const char* key);
+
     /*!
      * Returns true if a valid value is supplied by user
      */
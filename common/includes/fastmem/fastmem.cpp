@@ -0,0 +1,233 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+#include "fastmem.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FASTMEM_X86 1
+#include <immintrin.h>
+#endif
+
+namespace xcl {
+
+namespace {
+
+// Below this size non-temporal stores lose against memcpy()/memset(), whose
+// result is still in cache when the caller touches it again
+const size_t stream_threshold = 1024 * 1024;
+// Smallest share of a buffer worth starting a thread for
+const size_t min_chunk = 4 * 1024 * 1024;
+
+enum store_isa { isa_scalar, isa_avx2, isa_avx512 };
+
+store_isa detect_isa() {
+#ifdef FASTMEM_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return isa_avx512;
+    if (__builtin_cpu_supports("avx2")) return isa_avx2;
+#endif
+    return isa_scalar;
+}
+
+store_isa current_isa() {
+    static const store_isa isa = detect_isa();
+    return isa;
+}
+
+// A pattern of period P is written from a source holding P + 64 bytes of it,
+// so any 64 byte block of output is a single unaligned load at the current
+// phase.
+std::vector<unsigned char> expand_pattern(const unsigned char* pattern, size_t period) {
+    std::vector<unsigned char> rep(period + 64);
+    for (size_t i = 0; i < rep.size(); i++) rep[i] = pattern[i % period];
+    return rep;
+}
+
+void copy_scalar(unsigned char* dst, const unsigned char* src, size_t bytes) {
+    memcpy(dst, src, bytes);
+}
+
+void pattern_scalar(unsigned char* dst, size_t bytes, const unsigned char* rep, size_t period, size_t phase) {
+    while (bytes) {
+        size_t n = std::min(bytes, period - phase);
+        memcpy(dst, rep + phase, n);
+        dst += n;
+        bytes -= n;
+        phase = 0;
+    }
+}
+
+#ifdef FASTMEM_X86
+__attribute__((target("avx2"))) void copy_avx2(unsigned char* dst, const unsigned char* src, size_t bytes) {
+    size_t head = std::min(bytes, (32 - (reinterpret_cast<uintptr_t>(dst) & 31)) & 31);
+    memcpy(dst, src, head);
+    dst += head;
+    src += head;
+    bytes -= head;
+    for (; bytes >= 32; bytes -= 32, dst += 32, src += 32) {
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(dst),
+                            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src)));
+    }
+    memcpy(dst, src, bytes);
+    _mm_sfence();
+}
+
+__attribute__((target("avx2"))) void pattern_avx2(
+    unsigned char* dst, size_t bytes, const unsigned char* rep, size_t period, size_t phase) {
+    for (; bytes && (reinterpret_cast<uintptr_t>(dst) & 31); bytes--) {
+        *dst++ = rep[phase];
+        if (++phase == period) phase = 0;
+    }
+    for (; bytes >= 32; bytes -= 32, dst += 32) {
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(dst),
+                            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rep + phase)));
+        phase += 32;
+        if (phase >= period) phase %= period;
+    }
+    pattern_scalar(dst, bytes, rep, period, phase);
+    _mm_sfence();
+}
+
+__attribute__((target("avx512f"))) void copy_avx512(unsigned char* dst, const unsigned char* src, size_t bytes) {
+    size_t head = std::min(bytes, (64 - (reinterpret_cast<uintptr_t>(dst) & 63)) & 63);
+    memcpy(dst, src, head);
+    dst += head;
+    src += head;
+    bytes -= head;
+    for (; bytes >= 64; bytes -= 64, dst += 64, src += 64) {
+        _mm512_stream_si512(reinterpret_cast<__m512i*>(dst), _mm512_loadu_si512(src));
+    }
+    memcpy(dst, src, bytes);
+    _mm_sfence();
+}
+
+__attribute__((target("avx512f"))) void pattern_avx512(
+    unsigned char* dst, size_t bytes, const unsigned char* rep, size_t period, size_t phase) {
+    for (; bytes && (reinterpret_cast<uintptr_t>(dst) & 63); bytes--) {
+        *dst++ = rep[phase];
+        if (++phase == period) phase = 0;
+    }
+    for (; bytes >= 64; bytes -= 64, dst += 64) {
+        _mm512_stream_si512(reinterpret_cast<__m512i*>(dst), _mm512_loadu_si512(rep + phase));
+        phase += 64;
+        if (phase >= period) phase %= period;
+    }
+    pattern_scalar(dst, bytes, rep, period, phase);
+    _mm_sfence();
+}
+#endif
+
+void copy_range(unsigned char* dst, const unsigned char* src, size_t bytes, bool stream) {
+#ifdef FASTMEM_X86
+    if (stream && current_isa() == isa_avx512) return copy_avx512(dst, src, bytes);
+    if (stream && current_isa() == isa_avx2) return copy_avx2(dst, src, bytes);
+#endif
+    copy_scalar(dst, src, bytes);
+}
+
+void pattern_range(
+    unsigned char* dst, size_t bytes, const unsigned char* rep, size_t period, size_t phase, bool stream) {
+#ifdef FASTMEM_X86
+    if (stream && current_isa() == isa_avx512) return pattern_avx512(dst, bytes, rep, period, phase);
+    if (stream && current_isa() == isa_avx2) return pattern_avx2(dst, bytes, rep, period, phase);
+#endif
+    pattern_scalar(dst, bytes, rep, period, phase);
+}
+
+// Calls body(begin, end) over [0, count) split into page aligned shares, one
+// per thread; the calling thread takes the first share.
+template <typename F>
+void split(size_t count, size_t unit_size, unsigned threads, F body) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t bytes = count * unit_size;
+    threads = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(threads, bytes / min_chunk)));
+
+    size_t align = std::max<size_t>(1, 4096 / unit_size);
+    size_t chunk = ((count + threads - 1) / threads + align - 1) / align * align;
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < threads && t * chunk < count; t++) {
+        workers.emplace_back(body, t * chunk, std::min(count, (t + 1) * chunk));
+    }
+    body(0, std::min(count, chunk));
+    for (auto& worker : workers) worker.join();
+}
+
+uint64_t splitmix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+} // namespace
+
+const char* fast_store_isa() {
+    switch (current_isa()) {
+        case isa_avx512:
+            return "avx512";
+        case isa_avx2:
+            return "avx2";
+        default:
+            return "scalar";
+    }
+}
+
+void fast_copy(void* dst, const void* src, size_t bytes, unsigned threads) {
+    unsigned char* out = static_cast<unsigned char*>(dst);
+    const unsigned char* in = static_cast<const unsigned char*>(src);
+    bool stream = bytes >= stream_threshold;
+    split(bytes, 1, threads,
+          [=](size_t begin, size_t end) { copy_range(out + begin, in + begin, end - begin, stream); });
+}
+
+void fast_fill(void* dst, unsigned char value, size_t bytes, unsigned threads) {
+    if (bytes < stream_threshold) {
+        memset(dst, value, bytes);
+        return;
+    }
+    fast_fill_pattern(dst, bytes, &value, 1, threads);
+}
+
+void fast_fill_pattern(void* dst, size_t bytes, const void* pattern, size_t pattern_size, unsigned threads) {
+    if (pattern_size == 0) return;
+    unsigned char* out = static_cast<unsigned char*>(dst);
+    std::vector<unsigned char> rep = expand_pattern(static_cast<const unsigned char*>(pattern), pattern_size);
+    const unsigned char* src = rep.data();
+    bool stream = bytes >= stream_threshold;
+    split(bytes, 1, threads, [=](size_t begin, size_t end) {
+        pattern_range(out + begin, end - begin, src, pattern_size, begin % pattern_size, stream);
+    });
+}
+
+void fast_fill_ramp(void* dst, size_t bytes, unsigned threads) {
+    unsigned char ramp[256];
+    for (int i = 0; i < 256; i++) ramp[i] = i;
+    fast_fill_pattern(dst, bytes, ramp, sizeof(ramp), threads);
+}
+
+void fast_fill_random(int* dst, size_t count, uint64_t seed, unsigned threads) {
+    split(count, sizeof(int), threads, [=](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            dst[i] = static_cast<int>((splitmix64(seed + i) >> 33) % (static_cast<uint64_t>(RAND_MAX) + 1));
+        }
+    });
+}
+
+} // namespace xcl
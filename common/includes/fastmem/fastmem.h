@@ -0,0 +1,55 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+#ifndef FASTMEM_H_
+#define FASTMEM_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace xcl {
+
+/*!
+ * Synopsis:
+ * 1.Copies, fills and generates test data in large host buffers, typically
+ *      the mapping of a device buffer.
+ * 2.Splits the buffer across threads and writes it with AVX-512 or AVX2
+ *      non-temporal stores when the CPU has them, so the data does not
+ *      evict the caches on its way to memory the device will read.
+ * 3.Falls back to memcpy()/memset() on other CPUs and for small buffers.
+ *
+ * threads of 0 uses every hardware thread; buffers below a few MB are
+ * always handled by the calling thread.
+ */
+
+// "avx512", "avx2" or "scalar", whichever store path this CPU uses
+const char* fast_store_isa();
+
+void fast_copy(void* dst, const void* src, size_t bytes, unsigned threads = 0);
+void fast_fill(void* dst, unsigned char value, size_t bytes, unsigned threads = 0);
+
+// dst[i] = pattern[i % pattern_size]
+void fast_fill_pattern(void* dst, size_t bytes, const void* pattern, size_t pattern_size, unsigned threads = 0);
+
+// dst[i] = i % 256, the ramp most bandwidth tests use as input
+void fast_fill_ramp(void* dst, size_t bytes, unsigned threads = 0);
+
+// Pseudo-random values that only depend on seed and i, so the result is the
+// same whatever the thread count. Values are in [0, RAND_MAX] like rand().
+void fast_fill_random(int* dst, size_t count, uint64_t seed, unsigned threads = 0);
+
+} // namespace xcl
+
+#endif
@@ -0,0 +1,140 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+#include "lane_pack.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LANE_PACK_X86 1
+#include <immintrin.h>
+#endif
+
+namespace xcl {
+
+namespace {
+
+uint32_t float_bits(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+float bits_float(uint32_t bits) {
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Rounds to nearest even the bits of mantissa below shift, as the F16C
+// instructions do
+uint32_t round_shift(uint32_t mantissa, int shift) {
+    uint32_t rest = mantissa & ((1u << shift) - 1);
+    uint32_t half = 1u << (shift - 1);
+    uint32_t result = mantissa >> shift;
+    if (rest > half || (rest == half && (result & 1))) result++;
+    return result;
+}
+
+bool has_f16c() {
+#ifdef LANE_PACK_X86
+    static const bool f16c = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+    }();
+    return f16c;
+#else
+    return false;
+#endif
+}
+
+#ifdef LANE_PACK_X86
+__attribute__((target("avx,f16c"))) size_t to_half_f16c(half_t* dst, const float* src, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), h);
+    }
+    return i;
+}
+
+__attribute__((target("avx,f16c"))) size_t to_float_f16c(float* dst, const half_t* src, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+    }
+    return i;
+}
+#endif
+
+} // namespace
+
+half_t to_half(float value) {
+    uint32_t bits = float_bits(value);
+    uint16_t sign = (bits >> 16) & 0x8000;
+    uint32_t abs = bits & 0x7fffffff;
+    half_t result;
+    if (abs > 0x7f800000) {
+        // NaN, quieted, keeping the top of the payload
+        result.bits = sign | 0x7e00 | ((abs >> 13) & 0x3ff);
+    } else if (abs >= 0x477ff000) {
+        // Infinity, or rounds past 65504
+        result.bits = sign | 0x7c00;
+    } else if (abs >= 0x38800000) {
+        // Normal, the exponent bias goes from 127 to 15
+        result.bits = sign | round_shift(abs - 0x38000000, 13);
+    } else if (abs > 0x33000000) {
+        // Subnormal, in units of 2^-24; may round up to the smallest normal
+        int exponent = abs >> 23;
+        result.bits = sign | round_shift((abs & 0x7fffff) | 0x800000, 126 - exponent);
+    } else {
+        // 2^-25 or less is a tie or below, it rounds to zero
+        result.bits = sign;
+    }
+    return result;
+}
+
+float to_float(half_t value) {
+    uint32_t sign = (uint32_t)(value.bits & 0x8000) << 16;
+    uint32_t exponent = (value.bits >> 10) & 0x1f;
+    uint32_t mantissa = value.bits & 0x3ff;
+    if (exponent == 0x1f) return bits_float(sign | 0x7f800000 | (mantissa ? 0x400000 | (mantissa << 13) : 0));
+    if (exponent == 0) return bits_float(sign | float_bits(mantissa * (1.0f / (1 << 24))));
+    return bits_float(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+size_t pack_lanes(half_t* dst, const float* src, size_t count) {
+    size_t i = 0;
+#ifdef LANE_PACK_X86
+    if (has_f16c()) i = to_half_f16c(dst, src, count);
+#endif
+    for (; i < count; i++) dst[i] = to_half(src[i]);
+    size_t padded = padded_lanes<half_t>(count);
+    memset(dst + count, 0, (padded - count) * sizeof(half_t));
+    return padded;
+}
+
+void unpack_lanes(float* dst, const half_t* src, size_t count) {
+    size_t i = 0;
+#ifdef LANE_PACK_X86
+    if (has_f16c()) i = to_float_f16c(dst, src, count);
+#endif
+    for (; i < count; i++) dst[i] = to_float(src[i]);
+}
+
+const char* half_convert_isa() {
+    return has_f16c() ? "f16c" : "scalar";
+}
+
+} // namespace xcl
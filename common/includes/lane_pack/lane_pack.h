@@ -0,0 +1,80 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+#ifndef LANE_PACK_H_
+#define LANE_PACK_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace xcl {
+
+/*!
+ * Synopsis:
+ * 1.Lays out host values as the lanes of 512 bit memory beats, the layout
+ *      of hls::vector<T, 64 / sizeof(T)> kernel arguments: 64 int8_t, 32
+ *      int16_t or half, 16 int32_t or float values per beat.
+ * 2.Converts on the way in and out: integers with static_cast, so narrow
+ *      types keep the low bits, and float to IEEE binary16 with round to
+ *      nearest even, using F16C instructions when the CPU has them.
+ * 3.Zero-fills the lanes of the last beat that are past the element count,
+ *      so a kernel moving whole beats reads defined values.
+ *
+ * Packing writes padded_lanes<T>(count) elements to dst, unpacking reads
+ * only count of them.
+ */
+
+// Bytes in one beat of a 512 bit memory port
+const size_t beat_bytes = 64;
+
+// IEEE 754 binary16 value, the bits of an HLS half in device memory
+struct half_t {
+    uint16_t bits;
+};
+
+template <typename T>
+inline size_t padded_lanes(size_t count) {
+    static_assert(beat_bytes % sizeof(T) == 0, "a beat must hold a whole number of elements");
+    const size_t lanes = beat_bytes / sizeof(T);
+    return (count + lanes - 1) / lanes * lanes;
+}
+
+half_t to_half(float value);
+float to_float(half_t value);
+
+// Returns padded_lanes<T>(count)
+template <typename T, typename S>
+size_t pack_lanes(T* dst, const S* src, size_t count) {
+    for (size_t i = 0; i < count; i++) dst[i] = static_cast<T>(src[i]);
+    size_t padded = padded_lanes<T>(count);
+    memset(dst + count, 0, (padded - count) * sizeof(T));
+    return padded;
+}
+
+template <typename T, typename S>
+void unpack_lanes(S* dst, const T* src, size_t count) {
+    for (size_t i = 0; i < count; i++) dst[i] = static_cast<S>(src[i]);
+}
+
+size_t pack_lanes(half_t* dst, const float* src, size_t count);
+void unpack_lanes(float* dst, const half_t* src, size_t count);
+
+// Name of the float/half conversion path, "f16c" or "scalar"
+const char* half_convert_isa();
+
+} // namespace xcl
+
+#endif
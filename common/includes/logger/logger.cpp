@@ -15,9 +15,14 @@
 */
 #include "logger.h"
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <fstream>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <stdarg.h>
+#include <thread>
 #include <time.h>
 #ifdef WINDOWS
 #include <direct.h>
@@ -176,4 +181,267 @@ void LogWrapper(int etype, const char* file, int line, const char* desc, ...) {
     return;
 }
 
+///////////////////////////////////////////////////////////////////////
+namespace {
+
+// Records per thread; a power of two
+const uint64_t ring_size = 1024;
+
+// Single producer (the owning thread), single consumer (whoever holds the
+// drain lock)
+struct LogRing {
+    LogRecord slots[ring_size];
+    std::atomic<uint64_t> head{0};
+    std::atomic<uint64_t> tail{0};
+    std::atomic<bool> closed{false};
+};
+
+const char* LogTypeName(int etype) {
+    switch (etype) {
+        case (sda::etError):
+            return "ERROR";
+        case (sda::etWarning):
+            return "WARN";
+        default:
+            return "INFO";
+    }
+}
+
+// Replays the printf conversions of desc against the stored arguments. Length
+// modifiers in desc are ignored; the stored type decides the width instead.
+string FormatMessage(const LogRecord& r) {
+    string msg;
+    char buf[512];
+    int next = 0;
+    for (const char* p = r.desc; *p; p++) {
+        if (*p != '%') {
+            msg += *p;
+            continue;
+        }
+        if (p[1] == '%') {
+            msg += '%';
+            p++;
+            continue;
+        }
+        const char* start = p++;
+        string spec = "%";
+        while (*p && strchr("-+ #0123456789.", *p)) spec += *p++;
+        while (*p && strchr("hlLqjzt", *p)) p++;
+        if (*p == '\0') {
+            msg.append(start);
+            break;
+        }
+        if (next == r.argc) {
+            msg.append(start, p + 1);
+            continue;
+        }
+        const LogArg& arg = r.args[next];
+        unsigned char tag = r.tags[next++];
+        long long ivalue = tag == eaDouble ? static_cast<long long>(arg.d) : arg.i;
+        double dvalue = tag == eaDouble ? arg.d : static_cast<double>(arg.i);
+        switch (*p) {
+            case 'd':
+            case 'i':
+                snprintf(buf, sizeof(buf), (spec + "lld").c_str(), ivalue);
+                break;
+            case 'u':
+            case 'o':
+            case 'x':
+            case 'X':
+                snprintf(buf, sizeof(buf), (spec + "ll" + *p).c_str(), static_cast<unsigned long long>(ivalue));
+                break;
+            case 'c':
+                snprintf(buf, sizeof(buf), (spec + "c").c_str(), static_cast<int>(ivalue));
+                break;
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A':
+                snprintf(buf, sizeof(buf), (spec + *p).c_str(), dvalue);
+                break;
+            case 's':
+                snprintf(buf, sizeof(buf), (spec + "s").c_str(), tag == eaString ? r.text + arg.text : "(?)");
+                break;
+            case 'p':
+                snprintf(buf, sizeof(buf), "%p", tag == eaPointer ? arg.p : nullptr);
+                break;
+            default:
+                snprintf(buf, sizeof(buf), "%.*s", static_cast<int>(p + 1 - start), start);
+                break;
+        }
+        msg += buf;
+    }
+    return msg;
+}
+
+// Same layout as LogWrapper
+void FormatRecord(const LogRecord& r, string& out) {
+    const char* file = r.file;
+    const char* slash = strrchr(file, '/');
+    if (slash == nullptr) slash = strrchr(file, '\\');
+    if (slash != nullptr) file = slash + 1;
+
+    char header[512];
+    snprintf(header, sizeof(header), "%s: [%s:%d]", LogTypeName(r.type), file, r.line);
+    out += header;
+    out += ' ';
+
+#ifdef ENABLE_LOG_TIME
+    {
+        time_t rawtime = static_cast<time_t>(r.time_ns / 1000000000);
+        struct tm timeinfo;
+        char buffer[64];
+        localtime_r(&rawtime, &timeinfo);
+        strftime(buffer, sizeof(buffer), "TIME: [%a %b %e %H:%M:%S %Y]", &timeinfo);
+        out += buffer;
+    }
+#endif
+    out += ' ';
+    out += FormatMessage(r);
+    out += '\n';
+}
+
+class AsyncLogger {
+   public:
+    static AsyncLogger& instance() {
+        static AsyncLogger logger;
+        return logger;
+    }
+
+    std::shared_ptr<LogRing> add_ring() {
+        std::shared_ptr<LogRing> ring(new LogRing());
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_rings.push_back(ring);
+        return ring;
+    }
+
+    void wake() { m_wake.notify_one(); }
+
+    // Drains on the calling thread instead of waiting for the writer, so the
+    // output is written even if the program exits right after
+    void flush() {
+        std::vector<std::shared_ptr<LogRing> > rings;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            rings = m_rings;
+        }
+        drain(rings);
+    }
+
+    ~AsyncLogger() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_one();
+        m_thread.join();
+    }
+
+   private:
+    AsyncLogger() : m_stop(false) {
+#ifdef ENABLE_LOG_TOFILE
+        m_file.open("benchapp.log", std::ios_base::app);
+#endif
+        m_thread = std::thread(&AsyncLogger::run, this);
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            m_wake.wait_for(lock, std::chrono::milliseconds(2), [&] { return m_stop; });
+            bool stop = m_stop;
+            std::vector<std::shared_ptr<LogRing> > rings = m_rings;
+            lock.unlock();
+
+            drain(rings);
+
+            lock.lock();
+            // Rings of finished threads go away once they are empty
+            m_rings.erase(std::remove_if(m_rings.begin(), m_rings.end(),
+                                         [](const std::shared_ptr<LogRing>& ring) {
+                                             return ring->closed && ring->head == ring->tail;
+                                         }),
+                          m_rings.end());
+            if (stop) break;
+        }
+    }
+
+    // Formats everything committed so far, oldest first across threads, and
+    // writes it with a single call per sink. The writer thread and flushing
+    // callers take turns as the consumer of the rings.
+    void drain(const std::vector<std::shared_ptr<LogRing> >& rings) {
+        std::lock_guard<std::mutex> lock(m_drain_mutex);
+        std::vector<std::pair<int64_t, const LogRecord*> > batch;
+        std::vector<uint64_t> heads(rings.size());
+        for (size_t i = 0; i < rings.size(); i++) {
+            heads[i] = rings[i]->head.load(std::memory_order_acquire);
+            for (uint64_t n = rings[i]->tail.load(std::memory_order_relaxed); n != heads[i]; n++) {
+                const LogRecord* r = &rings[i]->slots[n & (ring_size - 1)];
+                batch.push_back(std::make_pair(r->time_ns, r));
+            }
+        }
+        if (batch.empty()) return;
+        std::stable_sort(batch.begin(), batch.end(),
+                         [](const std::pair<int64_t, const LogRecord*>& a,
+                            const std::pair<int64_t, const LogRecord*>& b) { return a.first < b.first; });
+
+        m_out.clear();
+        for (auto& entry : batch) FormatRecord(*entry.second, m_out);
+        for (size_t i = 0; i < rings.size(); i++) rings[i]->tail.store(heads[i], std::memory_order_release);
+
+        cout.write(m_out.data(), m_out.size());
+        cout.flush();
+#ifdef ENABLE_LOG_TOFILE
+        m_file.write(m_out.data(), m_out.size());
+        m_file.flush();
+#endif
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::vector<std::shared_ptr<LogRing> > m_rings;
+    bool m_stop;
+    // Serializes drain(); m_out is only used under it
+    std::mutex m_drain_mutex;
+    string m_out;
+    std::ofstream m_file;
+    std::thread m_thread;
+};
+
+// Gives the ring back to the writer thread when its thread exits
+struct LocalRing {
+    std::shared_ptr<LogRing> ring;
+    uint64_t head = 0;
+    ~LocalRing() {
+        if (ring) ring->closed = true;
+    }
+};
+
+thread_local LocalRing local_ring;
+
+} // namespace
+
+LogRecord& LogBegin() {
+    if (!local_ring.ring) local_ring.ring = AsyncLogger::instance().add_ring();
+    LogRing& ring = *local_ring.ring;
+    local_ring.head = ring.head.load(std::memory_order_relaxed);
+    while (local_ring.head - ring.tail.load(std::memory_order_acquire) >= ring_size) {
+        AsyncLogger::instance().wake();
+        std::this_thread::yield();
+    }
+    return ring.slots[local_ring.head & (ring_size - 1)];
+}
+
+void LogCommit() {
+    local_ring.ring->head.store(local_ring.head + 1, std::memory_order_release);
+}
+
+void LogFlush() {
+    AsyncLogger::instance().flush();
+}
+
 } // namespace sda
@@ -16,18 +16,44 @@
 #ifndef LOGGER_H_
 #define LOGGER_H_
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #define ENABLE_LOG_TOFILE 1
 #define ENABLE_LOG_TIME 1
 
+// Messages below this level (0 info, 1 warning, 2 error) are compiled out,
+// including the evaluation of their arguments
+#ifndef SDA_LOG_LEVEL
+#define SDA_LOG_LEVEL 0
+#endif
+
+// Messages at or above this level are written out before the call returns,
+// together with everything logged before them. By default only warnings and
+// errors are, info messages reach the console from the background thread
+// within a few milliseconds. Set it to 0 to keep info messages strictly
+// ordered with what the program prints to cout itself, or to 3 to leave
+// every level to the background thread.
+#ifndef SDA_LOG_SYNC_LEVEL
+#define SDA_LOG_SYNC_LEVEL 1
+#endif
+
 // global logging
-#define LogInfo(desc, ...) sda::LogWrapper(0, __FILE__, __LINE__, desc, ##__VA_ARGS__)
-#define LogWarn(desc, ...) sda::LogWrapper(1, __FILE__, __LINE__, desc, ##__VA_ARGS__)
-#define LogError(desc, ...) sda::LogWrapper(2, __FILE__, __LINE__, desc, ##__VA_ARGS__)
+#define SDA_LOG(etype, desc, ...)                                                                         \
+    do {                                                                                                  \
+        if ((etype) >= SDA_LOG_LEVEL)                                                                     \
+            sda::AsyncLog(etype, (etype) >= SDA_LOG_SYNC_LEVEL, __FILE__, __LINE__, desc, ##__VA_ARGS__); \
+    } while (0)
+#define LogInfo(desc, ...) SDA_LOG(0, desc, ##__VA_ARGS__)
+#define LogWarn(desc, ...) SDA_LOG(1, desc, ##__VA_ARGS__)
+#define LogError(desc, ...) SDA_LOG(2, desc, ##__VA_ARGS__)
 
 using namespace std;
 
@@ -64,7 +90,122 @@ void PrintPOD(const vector<T>& pod, size_t display_count = 0, const int precisio
 }
 
 // logging
+// Formats and writes the message synchronously, on the calling thread
 void LogWrapper(int etype, const char* file, int line, const char* desc, ...);
+
+// asynchronous logging
+// The caller only copies the format pointer and the raw arguments into a
+// fixed size record of its own lock-free ring; a background thread formats
+// the records, merges the rings by time and writes them in batches to cout
+// and benchapp.log. Strings are copied, so temporaries such as c_str() are
+// safe to pass. Messages selected by SDA_LOG_SYNC_LEVEL are flushed on the
+// calling thread before the call returns, so an error is on the console
+// before the caller goes on to exit().
+#define LOG_MAX_ARGS 8
+#define LOG_TEXT_BYTES 128
+
+enum LOGARG { eaInt, eaDouble, eaString, eaPointer };
+
+union LogArg {
+    long long i;
+    double d;
+    const void* p;
+    size_t text; // offset of a copied string in LogRecord::text
+};
+
+struct LogRecord {
+    int64_t time_ns;
+    const char* file;
+    const char* desc;
+    int line;
+    int type;
+    int argc;
+    int text_used;
+    unsigned char tags[LOG_MAX_ARGS];
+    LogArg args[LOG_MAX_ARGS];
+    char text[LOG_TEXT_BYTES];
+};
+
+// Slot of the calling thread's ring, waits while the ring is full
+LogRecord& LogBegin();
+void LogCommit();
+// Writes every record committed before the call, on the calling thread
+void LogFlush();
+
+inline void LogPackText(LogRecord& r, const char* str, size_t len) {
+    if (r.argc == LOG_MAX_ARGS) return;
+    size_t room = LOG_TEXT_BYTES - r.text_used;
+    if (room == 0) {
+        r.tags[r.argc] = eaString;
+        r.args[r.argc++].text = LOG_TEXT_BYTES - 1;
+        return;
+    }
+    len = std::min(len, room - 1);
+    memcpy(r.text + r.text_used, str, len);
+    r.text[r.text_used + len] = '\0';
+    r.tags[r.argc] = eaString;
+    r.args[r.argc++].text = r.text_used;
+    r.text_used += len + 1;
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type LogPackOne(LogRecord& r, T value) {
+    if (r.argc == LOG_MAX_ARGS) return;
+    r.tags[r.argc] = eaInt;
+    r.args[r.argc++].i = static_cast<long long>(value);
+}
+
+template <typename T>
+typename std::enable_if<std::is_floating_point<T>::value>::type LogPackOne(LogRecord& r, T value) {
+    if (r.argc == LOG_MAX_ARGS) return;
+    r.tags[r.argc] = eaDouble;
+    r.args[r.argc++].d = static_cast<double>(value);
+}
+
+template <typename T>
+void LogPackOne(LogRecord& r, T* ptr) {
+    if (r.argc == LOG_MAX_ARGS) return;
+    r.tags[r.argc] = eaPointer;
+    r.args[r.argc++].p = ptr;
+}
+
+inline void LogPackOne(LogRecord& r, const char* str) {
+    if (str == nullptr) str = "(null)";
+    LogPackText(r, str, strlen(str));
+}
+
+inline void LogPackOne(LogRecord& r, char* str) {
+    LogPackOne(r, static_cast<const char*>(str));
+}
+
+inline void LogPackOne(LogRecord& r, const string& str) {
+    LogPackText(r, str.data(), str.size());
+}
+
+inline void LogPack(LogRecord&) {}
+
+template <typename T, typename... Rest>
+void LogPack(LogRecord& r, const T& first, const Rest&... rest) {
+    LogPackOne(r, first);
+    LogPack(r, rest...);
+}
+
+template <typename... Args>
+void AsyncLog(int etype, bool flush, const char* file, int line, const char* desc, const Args&... args) {
+    LogRecord& r = LogBegin();
+    r.time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::system_clock::now().time_since_epoch())
+                    .count();
+    r.file = file;
+    r.desc = desc;
+    r.line = line;
+    r.type = etype;
+    r.argc = 0;
+    r.text_used = 0;
+    LogPack(r, args...);
+    LogCommit();
+    if (flush) LogFlush();
+}
 }
 
 #endif /* LOGGER_H_ */
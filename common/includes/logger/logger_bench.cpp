@@ -0,0 +1,113 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+
+/********************************************************************************************
+ * Description:
+ * Host only benchmark of the synchronous LogWrapper against LogInfo, both as
+ * built by default (written by the background thread) and with
+ * SDA_LOG_SYNC_LEVEL 0 (flushed before the call returns, "LogInfo sync").
+ * For each, every thread logs the same message a number of
+ * times; the benchmark reports messages per second and the latency seen by
+ * the caller. Console output is discarded while measuring, benchapp.log is
+ * written as usual.
+ *
+ * Build and run:
+ *   g++ -O2 -std=c++1y -pthread logger_bench.cpp logger.cpp -o logger_bench
+ *   ./logger_bench [messages per thread] [threads]
+ *
+ ******************************************************************************************/
+
+#include "logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+class null_buffer : public std::streambuf {
+   protected:
+    int overflow(int c) { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) { return n; }
+};
+
+struct bench_result {
+    double seconds;
+    std::vector<double> latencies_ns;
+};
+
+template <typename F>
+bench_result run(int messages, int threads, F log_one) {
+    bench_result result;
+    std::vector<std::vector<double> > latencies(threads, std::vector<double>(messages));
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            for (int i = 0; i < messages; i++) {
+                auto call_start = std::chrono::steady_clock::now();
+                log_one(t, i);
+                auto call_end = std::chrono::steady_clock::now();
+                latencies[t][i] = std::chrono::duration<double, std::nano>(call_end - call_start).count();
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    sda::LogFlush();
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (auto& l : latencies) result.latencies_ns.insert(result.latencies_ns.end(), l.begin(), l.end());
+    std::sort(result.latencies_ns.begin(), result.latencies_ns.end());
+    return result;
+}
+
+void report(const char* name, const bench_result& r) {
+    const std::vector<double>& l = r.latencies_ns;
+    printf("%-14s %12.0f msg/s   p50 %9.0f ns   p99 %9.0f ns   max %10.0f ns\n", name, l.size() / r.seconds,
+           l[l.size() / 2], l[l.size() * 99 / 100], l.back());
+}
+
+int main(int argc, char* argv[]) {
+    int messages = argc > 1 ? atoi(argv[1]) : 20000;
+    int threads = argc > 2 ? atoi(argv[2]) : 1;
+    if (messages <= 0 || threads <= 0) {
+        printf("Usage: %s [messages per thread] [threads]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    null_buffer sink;
+    std::streambuf* console = std::cout.rdbuf(&sink);
+
+    bench_result sync = run(messages, threads, [](int t, int i) {
+        sda::LogWrapper(sda::etInfo, __FILE__, __LINE__, "thread %d message %d value %f tag %s", t, i, i * 0.5,
+                        "bench");
+    });
+    // LogInfo as built by default, and as built with SDA_LOG_SYNC_LEVEL 0
+    bench_result async = run(messages, threads, [](int t, int i) {
+        LogInfo("thread %d message %d value %f tag %s", t, i, i * 0.5, "bench");
+    });
+    bench_result flushed = run(messages, threads, [](int t, int i) {
+        sda::AsyncLog(sda::etInfo, true, __FILE__, __LINE__, "thread %d message %d value %f tag %s", t, i, i * 0.5,
+                      "bench");
+    });
+
+    std::cout.rdbuf(console);
+    printf("%d message(s) x %d thread(s)\n", messages, threads);
+    report("LogWrapper", sync);
+    report("LogInfo", async);
+    report("LogInfo sync", flushed);
+    return EXIT_SUCCESS;
+}
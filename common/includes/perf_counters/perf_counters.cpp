@@ -0,0 +1,266 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+#include "perf_counters.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace xcl {
+
+namespace {
+
+#ifdef __linux__
+struct event_config {
+    uint32_t type;
+    uint64_t config;
+};
+
+// First choice and fallback of each event; LLC read misses are not exposed
+// on every CPU, the generic cache miss event is close enough
+const event_config configs[perf_counters::num_events][2] = {
+    {{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES}, {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES}},
+    {{PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS}, {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS}},
+    {{PERF_TYPE_HW_CACHE,
+      PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+     {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES}},
+    {{PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS}, {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS}},
+    {{PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES}, {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES}}};
+
+int open_event(uint32_t type, uint64_t config, int tid) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    int fd = syscall(__NR_perf_event_open, &attr, tid, -1, -1, PERF_FLAG_FD_CLOEXEC);
+    if (fd < 0 && (errno == EACCES || errno == EPERM)) {
+        // perf_event_paranoid 2 still allows user space only counting
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = syscall(__NR_perf_event_open, &attr, tid, -1, -1, PERF_FLAG_FD_CLOEXEC);
+    }
+    return fd;
+}
+
+std::vector<int> list_threads() {
+    std::vector<int> tids;
+    DIR* dir = opendir("/proc/self/task");
+    if (dir == nullptr) return tids;
+    while (dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') tids.push_back(atoi(entry->d_name));
+    }
+    closedir(dir);
+    return tids;
+}
+#endif
+
+// 1234567 -> "1.23M"
+std::string short_count(double value) {
+    const char* suffix[] = {"", "K", "M", "G", "T"};
+    int i = 0;
+    while (value >= 1000 && i < 4) {
+        value /= 1000;
+        i++;
+    }
+    char buf[32];
+    snprintf(buf, sizeof(buf), i ? "%.3g%s" : "%.0f%s", value, suffix[i]);
+    return buf;
+}
+
+} // namespace
+
+perf_counters::perf_counters(bool enable) {
+    for (int e = 0; e < num_events; e++) {
+        m_available[e] = false;
+        m_type[e] = 0;
+        m_config[e] = 0;
+        m_value[e] = 0;
+    }
+    if (!enable) return;
+
+#ifdef __linux__
+    // Probe on the calling thread which events this host supports
+    int err = 0;
+    for (int e = 0; e < num_events; e++) {
+        for (auto& cfg : configs[e]) {
+            int fd = open_event(cfg.type, cfg.config, 0);
+            if (fd < 0) {
+                err = errno;
+                continue;
+            }
+            close(fd);
+            m_available[e] = true;
+            m_type[e] = cfg.type;
+            m_config[e] = cfg.config;
+            break;
+        }
+    }
+    if (!available()) {
+        printf("WARNING: perf_event_open() failed (%s), host counters are not reported. "
+               "Check /proc/sys/kernel/perf_event_paranoid\n",
+               strerror(err));
+    }
+#else
+    printf("WARNING: perf events are only supported on Linux, host counters are not reported\n");
+#endif
+}
+
+perf_counters::~perf_counters() {
+#ifdef __linux__
+    for (auto& thread : m_fds) {
+        for (int fd : thread.second) {
+            if (fd >= 0) close(fd);
+        }
+    }
+#endif
+}
+
+bool perf_counters::available() const {
+    for (int e = 0; e < num_events; e++) {
+        if (m_available[e]) return true;
+    }
+    return false;
+}
+
+void perf_counters::attach_new_threads() {
+#ifdef __linux__
+    std::vector<int> tids = list_threads();
+    // Forget threads that have exited
+    for (auto it = m_fds.begin(); it != m_fds.end();) {
+        bool alive = false;
+        for (int tid : tids) alive |= tid == it->first;
+        if (alive) {
+            ++it;
+            continue;
+        }
+        for (int fd : it->second) {
+            if (fd >= 0) close(fd);
+        }
+        it = m_fds.erase(it);
+    }
+    for (int tid : tids) {
+        if (m_fds.count(tid)) continue;
+        std::vector<int>& fds = m_fds[tid];
+        for (int e = 0; e < num_events; e++) {
+            fds.push_back(m_available[e] ? open_event(m_type[e], m_config[e], tid) : -1);
+        }
+    }
+#endif
+}
+
+void perf_counters::start() {
+    if (!available()) return;
+    attach_new_threads();
+#ifdef __linux__
+    for (auto& thread : m_fds) {
+        for (int fd : thread.second) {
+            if (fd < 0) continue;
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+}
+
+void perf_counters::stop() {
+    if (!available()) return;
+#ifdef __linux__
+    for (auto& thread : m_fds) {
+        for (int fd : thread.second) {
+            if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+    for (int e = 0; e < num_events; e++) {
+        double total = 0;
+        for (auto& thread : m_fds) {
+            int fd = thread.second[e];
+            uint64_t data[3]; // value, time enabled, time running
+            if (fd < 0 || read(fd, data, sizeof(data)) != sizeof(data) || data[2] == 0) continue;
+            total += data[2] < data[1] ? (double)data[0] * data[1] / data[2] : data[0];
+        }
+        m_value[e] = static_cast<uint64_t>(total);
+    }
+#endif
+}
+
+void perf_counters::pause() {
+    if (!available()) return;
+#ifdef __linux__
+    for (auto& thread : m_fds) {
+        for (int fd : thread.second) {
+            if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+#endif
+}
+
+void perf_counters::resume() {
+    if (!available()) return;
+#ifdef __linux__
+    for (auto& thread : m_fds) {
+        for (int fd : thread.second) {
+            if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+}
+
+std::string perf_counters::summary(double per) const {
+    if (!available()) return "";
+    std::string text;
+    for (int e = 0; e < num_events; e++) {
+        if (e) text += ", ";
+        text += name(static_cast<event>(e));
+        text += " ";
+        text += m_available[e] ? short_count(m_value[e] / per) : "n/a";
+        if (e == instructions && m_available[cycles] && m_available[instructions] && m_value[cycles]) {
+            char ipc[32];
+            snprintf(ipc, sizeof(ipc), " (IPC %.2f)", (double)m_value[instructions] / m_value[cycles]);
+            text += ipc;
+        }
+    }
+    return text;
+}
+
+const char* perf_counters::name(event e) {
+    switch (e) {
+        case cycles:
+            return "cycles";
+        case instructions:
+            return "instructions";
+        case llc_misses:
+            return "LLC misses";
+        case page_faults:
+            return "page faults";
+        case context_switches:
+            return "context switches";
+        default:
+            return "unknown";
+    }
+}
+
+} // namespace xcl
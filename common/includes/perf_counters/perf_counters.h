@@ -0,0 +1,81 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+#ifndef PERF_COUNTERS_H_
+#define PERF_COUNTERS_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace xcl {
+
+/*!
+ * Synopsis:
+ * 1.Counts CPU cycles, instructions, last level cache misses, page faults
+ *      and context switches of the host process between start() and stop()
+ *      with perf_event_open().
+ * 2.Covers every thread of the process, including the runtime threads that
+ *      carry out migrations and syncs; threads are picked up at each start().
+ * 3.Degrades cleanly: counters the kernel or the CPU does not provide are
+ *      reported as n/a, and if none can be opened (perf_event_paranoid,
+ *      containers, non Linux hosts) a single warning is printed and
+ *      available() returns false.
+ */
+class perf_counters {
+   public:
+    enum event { cycles, instructions, llc_misses, page_faults, context_switches, num_events };
+
+    explicit perf_counters(bool enable = true);
+    ~perf_counters();
+    perf_counters(const perf_counters&) = delete;
+    perf_counters& operator=(const perf_counters&) = delete;
+
+    // True if at least one counter could be opened
+    bool available() const;
+    bool available(event e) const { return m_available[e]; }
+
+    void start();
+    void stop();
+    // Leave work between start() and stop() out of the count, e.g. the
+    // untimed preparation inside a benchmark body
+    void pause();
+    void resume();
+
+    // Count of the last start()/stop() region, scaled up if the kernel had
+    // to multiplex the hardware counters
+    uint64_t value(event e) const { return m_value[e]; }
+
+    // "cycles 1.2G, instructions 2.5G (IPC 2.08), LLC misses 31.5K, ...",
+    // every count divided by per (e.g. the number of repetitions), or an
+    // empty string when no counter is available
+    std::string summary(double per = 1) const;
+
+    static const char* name(event e);
+
+   private:
+    void attach_new_threads();
+
+    bool m_available[num_events];
+    uint32_t m_type[num_events]; // perf_event_attr type and config that worked
+    uint64_t m_config[num_events];
+    uint64_t m_value[num_events];
+    std::map<int, std::vector<int> > m_fds; // thread id -> one fd per event, -1 if not open
+};
+
+} // namespace xcl
+
+#endif
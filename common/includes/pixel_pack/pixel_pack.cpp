@@ -0,0 +1,343 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+#include "pixel_pack.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PIXEL_PACK_X86 1
+#include <immintrin.h>
+#endif
+
+namespace xcl {
+
+namespace {
+
+pixel_isa detect_isa() {
+#ifdef PIXEL_PACK_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return pixel_isa_avx2;
+    if (__builtin_cpu_supports("ssse3")) return pixel_isa_ssse3;
+#endif
+    return pixel_isa_scalar;
+}
+
+pixel_isa resolve(pixel_isa isa) {
+    pixel_isa best = pixel_best_isa();
+    return isa == pixel_isa_auto || isa > best ? best : isa;
+}
+
+// Scalar reference paths, also used for the tails of the vector loops
+
+void rgb24_to_rgba32_scalar(uint32_t* dst, const unsigned char* src, size_t pixels, uint32_t alpha) {
+    for (size_t i = 0; i < pixels; i++, src += 3) dst[i] = src[0] | (src[1] << 8) | (src[2] << 16) | alpha;
+}
+
+void rgba32_to_rgb24_scalar(unsigned char* dst, const uint32_t* src, size_t pixels) {
+    for (size_t i = 0; i < pixels; i++, dst += 3) {
+        dst[0] = src[i] & 0xff;
+        dst[1] = (src[i] >> 8) & 0xff;
+        dst[2] = (src[i] >> 16) & 0xff;
+    }
+}
+
+void rgb24_to_planar_scalar(
+    unsigned char* p0, unsigned char* p1, unsigned char* p2, const unsigned char* src, size_t pixels) {
+    for (size_t i = 0; i < pixels; i++, src += 3) {
+        p0[i] = src[0];
+        p1[i] = src[1];
+        p2[i] = src[2];
+    }
+}
+
+void planar_to_rgb24_scalar(
+    unsigned char* dst, const unsigned char* p0, const unsigned char* p1, const unsigned char* p2, size_t pixels) {
+    for (size_t i = 0; i < pixels; i++, dst += 3) {
+        dst[0] = p0[i];
+        dst[1] = p1[i];
+        dst[2] = p2[i];
+    }
+}
+
+#ifdef PIXEL_PACK_X86
+// Shuffle controls between 48 bytes of packed pixels (three 16 byte chunks)
+// and 16 bytes of each plane. split[k][q] gathers the bytes of plane k found
+// in chunk q, merge[q][k] scatters plane k into chunk q; 0x80 clears a byte.
+struct planar_masks {
+    unsigned char split[3][3][16];
+    unsigned char merge[3][3][16];
+
+    planar_masks() {
+        for (int k = 0; k < 3; k++) {
+            for (int q = 0; q < 3; q++) {
+                for (int j = 0; j < 16; j++) {
+                    int s = 3 * j + k; // packed byte of plane byte j
+                    split[k][q][j] = s / 16 == q ? s % 16 : 0x80;
+                    int m = 16 * q + j; // packed byte j of chunk q
+                    merge[q][k][j] = m % 3 == k ? m / 3 : 0x80;
+                }
+            }
+        }
+    }
+};
+
+const planar_masks& masks() {
+    static const planar_masks m;
+    return m;
+}
+
+inline __m128i load128(const void* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+inline void store128(void* p, __m128i v) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+}
+
+__attribute__((target("ssse3"))) void rgb24_to_rgba32_ssse3(uint32_t* dst,
+                                                            const unsigned char* src,
+                                                            size_t pixels,
+                                                            uint32_t alpha) {
+    const __m128i spread = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i top = _mm_set1_epi32(alpha);
+    size_t i = 0;
+    for (; i + 16 <= pixels; i += 16, src += 48) {
+        __m128i in0 = load128(src);
+        __m128i in1 = load128(src + 16);
+        __m128i in2 = load128(src + 32);
+        store128(dst + i, _mm_or_si128(_mm_shuffle_epi8(in0, spread), top));
+        store128(dst + i + 4, _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(in1, in0, 12), spread), top));
+        store128(dst + i + 8, _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(in2, in1, 8), spread), top));
+        store128(dst + i + 12, _mm_or_si128(_mm_shuffle_epi8(_mm_srli_si128(in2, 4), spread), top));
+    }
+    rgb24_to_rgba32_scalar(dst + i, src, pixels - i, alpha);
+}
+
+__attribute__((target("ssse3"))) void rgba32_to_rgb24_ssse3(unsigned char* dst, const uint32_t* src, size_t pixels) {
+    const __m128i gather = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    size_t i = 0;
+    for (; i + 16 <= pixels; i += 16, dst += 48) {
+        __m128i p0 = _mm_shuffle_epi8(load128(src + i), gather);
+        __m128i p1 = _mm_shuffle_epi8(load128(src + i + 4), gather);
+        __m128i p2 = _mm_shuffle_epi8(load128(src + i + 8), gather);
+        __m128i p3 = _mm_shuffle_epi8(load128(src + i + 12), gather);
+        store128(dst, _mm_or_si128(p0, _mm_slli_si128(p1, 12)));
+        store128(dst + 16, _mm_or_si128(_mm_srli_si128(p1, 4), _mm_slli_si128(p2, 8)));
+        store128(dst + 32, _mm_or_si128(_mm_srli_si128(p2, 8), _mm_slli_si128(p3, 4)));
+    }
+    rgba32_to_rgb24_scalar(dst, src + i, pixels - i);
+}
+
+__attribute__((target("ssse3"))) void rgb24_to_planar_ssse3(
+    unsigned char* p0, unsigned char* p1, unsigned char* p2, const unsigned char* src, size_t pixels) {
+    const planar_masks& m = masks();
+    unsigned char* planes[3] = {p0, p1, p2};
+    __m128i split[3][3];
+    for (int k = 0; k < 3; k++) {
+        for (int q = 0; q < 3; q++) split[k][q] = load128(m.split[k][q]);
+    }
+    size_t i = 0;
+    for (; i + 16 <= pixels; i += 16, src += 48) {
+        __m128i in[3] = {load128(src), load128(src + 16), load128(src + 32)};
+        for (int k = 0; k < 3; k++) {
+            __m128i plane = _mm_or_si128(_mm_shuffle_epi8(in[0], split[k][0]), _mm_shuffle_epi8(in[1], split[k][1]));
+            store128(planes[k] + i, _mm_or_si128(plane, _mm_shuffle_epi8(in[2], split[k][2])));
+        }
+    }
+    rgb24_to_planar_scalar(p0 + i, p1 + i, p2 + i, src, pixels - i);
+}
+
+__attribute__((target("ssse3"))) void planar_to_rgb24_ssse3(
+    unsigned char* dst, const unsigned char* p0, const unsigned char* p1, const unsigned char* p2, size_t pixels) {
+    const planar_masks& m = masks();
+    __m128i merge[3][3];
+    for (int q = 0; q < 3; q++) {
+        for (int k = 0; k < 3; k++) merge[q][k] = load128(m.merge[q][k]);
+    }
+    size_t i = 0;
+    for (; i + 16 <= pixels; i += 16, dst += 48) {
+        __m128i in[3] = {load128(p0 + i), load128(p1 + i), load128(p2 + i)};
+        for (int q = 0; q < 3; q++) {
+            __m128i out = _mm_or_si128(_mm_shuffle_epi8(in[0], merge[q][0]), _mm_shuffle_epi8(in[1], merge[q][1]));
+            store128(dst + 16 * q, _mm_or_si128(out, _mm_shuffle_epi8(in[2], merge[q][2])));
+        }
+    }
+    planar_to_rgb24_scalar(dst, p0 + i, p1 + i, p2 + i, pixels - i);
+}
+
+// The AVX2 paths reuse the 16 byte controls in both lanes: vpshufb does not
+// cross lanes, so each lane holds a block the SSSE3 code would handle.
+
+__attribute__((target("avx2"))) inline __m256i load2x128(const void* lo, const void* hi) {
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(load128(lo)), load128(hi), 1);
+}
+
+__attribute__((target("avx2"))) void rgb24_to_rgba32_avx2(uint32_t* dst,
+                                                          const unsigned char* src,
+                                                          size_t pixels,
+                                                          uint32_t alpha) {
+    const __m256i spread = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1, 0, 1, 2, -1, 3,
+                                            4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m256i top = _mm256_set1_epi32(alpha);
+    size_t i = 0;
+    // 8 pixels from src[0, 16) and src[12, 28): keep 4 bytes of input ahead
+    for (; i + 10 <= pixels; i += 8, src += 24) {
+        __m256i in = load2x128(src, src + 12);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_or_si256(_mm256_shuffle_epi8(in, spread), top));
+    }
+    rgb24_to_rgba32_scalar(dst + i, src, pixels - i, alpha);
+}
+
+__attribute__((target("avx2"))) void rgba32_to_rgb24_avx2(unsigned char* dst, const uint32_t* src, size_t pixels) {
+    const __m256i gather = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1, 0, 1, 2, 4, 5,
+                                            6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    const __m256i pack = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+    size_t i = 0;
+    // 24 bytes out per 32 byte store, the next store overwrites the rest
+    for (; i + 11 <= pixels; i += 8, dst += 24) {
+        __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        __m256i out = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(in, gather), pack);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), out);
+    }
+    rgba32_to_rgb24_scalar(dst, src + i, pixels - i);
+}
+
+__attribute__((target("avx2"))) void rgb24_to_planar_avx2(
+    unsigned char* p0, unsigned char* p1, unsigned char* p2, const unsigned char* src, size_t pixels) {
+    const planar_masks& m = masks();
+    unsigned char* planes[3] = {p0, p1, p2};
+    __m256i split[3][3];
+    for (int k = 0; k < 3; k++) {
+        for (int q = 0; q < 3; q++) split[k][q] = _mm256_broadcastsi128_si256(load128(m.split[k][q]));
+    }
+    size_t i = 0;
+    // Lane 0 holds pixels 0-15, lane 1 pixels 16-31
+    for (; i + 32 <= pixels; i += 32, src += 96) {
+        __m256i in[3] = {load2x128(src, src + 48), load2x128(src + 16, src + 64), load2x128(src + 32, src + 80)};
+        for (int k = 0; k < 3; k++) {
+            __m256i plane =
+                _mm256_or_si256(_mm256_shuffle_epi8(in[0], split[k][0]), _mm256_shuffle_epi8(in[1], split[k][1]));
+            plane = _mm256_or_si256(plane, _mm256_shuffle_epi8(in[2], split[k][2]));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(planes[k] + i), plane);
+        }
+    }
+    rgb24_to_planar_ssse3(p0 + i, p1 + i, p2 + i, src, pixels - i);
+}
+
+__attribute__((target("avx2"))) void planar_to_rgb24_avx2(
+    unsigned char* dst, const unsigned char* p0, const unsigned char* p1, const unsigned char* p2, size_t pixels) {
+    const planar_masks& m = masks();
+    __m256i merge[3][3];
+    for (int q = 0; q < 3; q++) {
+        for (int k = 0; k < 3; k++) merge[q][k] = _mm256_broadcastsi128_si256(load128(m.merge[q][k]));
+    }
+    size_t i = 0;
+    for (; i + 32 <= pixels; i += 32, dst += 96) {
+        __m256i in[3] = {_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p0 + i)),
+                         _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p1 + i)),
+                         _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p2 + i))};
+        for (int q = 0; q < 3; q++) {
+            __m256i out =
+                _mm256_or_si256(_mm256_shuffle_epi8(in[0], merge[q][0]), _mm256_shuffle_epi8(in[1], merge[q][1]));
+            out = _mm256_or_si256(out, _mm256_shuffle_epi8(in[2], merge[q][2]));
+            store128(dst + 16 * q, _mm256_castsi256_si128(out));
+            store128(dst + 48 + 16 * q, _mm256_extracti128_si256(out, 1));
+        }
+    }
+    planar_to_rgb24_ssse3(dst, p0 + i, p1 + i, p2 + i, pixels - i);
+}
+#endif
+
+} // namespace
+
+pixel_isa pixel_best_isa() {
+    static const pixel_isa isa = detect_isa();
+    return isa;
+}
+
+const char* pixel_isa_name(pixel_isa isa) {
+    switch (resolve(isa)) {
+        case pixel_isa_avx2:
+            return "avx2";
+        case pixel_isa_ssse3:
+            return "ssse3";
+        default:
+            return "scalar";
+    }
+}
+
+void rgb24_to_rgba32(uint32_t* dst, const unsigned char* src, size_t pixels, uint8_t alpha, pixel_isa isa) {
+    uint32_t top = static_cast<uint32_t>(alpha) << 24;
+    switch (resolve(isa)) {
+#ifdef PIXEL_PACK_X86
+        case pixel_isa_avx2:
+            return rgb24_to_rgba32_avx2(dst, src, pixels, top);
+        case pixel_isa_ssse3:
+            return rgb24_to_rgba32_ssse3(dst, src, pixels, top);
+#endif
+        default:
+            return rgb24_to_rgba32_scalar(dst, src, pixels, top);
+    }
+}
+
+void rgba32_to_rgb24(unsigned char* dst, const uint32_t* src, size_t pixels, pixel_isa isa) {
+    switch (resolve(isa)) {
+#ifdef PIXEL_PACK_X86
+        case pixel_isa_avx2:
+            return rgba32_to_rgb24_avx2(dst, src, pixels);
+        case pixel_isa_ssse3:
+            return rgba32_to_rgb24_ssse3(dst, src, pixels);
+#endif
+        default:
+            return rgba32_to_rgb24_scalar(dst, src, pixels);
+    }
+}
+
+void rgb24_to_planar(unsigned char* plane0,
+                     unsigned char* plane1,
+                     unsigned char* plane2,
+                     const unsigned char* src,
+                     size_t pixels,
+                     pixel_isa isa) {
+    switch (resolve(isa)) {
+#ifdef PIXEL_PACK_X86
+        case pixel_isa_avx2:
+            return rgb24_to_planar_avx2(plane0, plane1, plane2, src, pixels);
+        case pixel_isa_ssse3:
+            return rgb24_to_planar_ssse3(plane0, plane1, plane2, src, pixels);
+#endif
+        default:
+            return rgb24_to_planar_scalar(plane0, plane1, plane2, src, pixels);
+    }
+}
+
+void planar_to_rgb24(unsigned char* dst,
+                     const unsigned char* plane0,
+                     const unsigned char* plane1,
+                     const unsigned char* plane2,
+                     size_t pixels,
+                     pixel_isa isa) {
+    switch (resolve(isa)) {
+#ifdef PIXEL_PACK_X86
+        case pixel_isa_avx2:
+            return planar_to_rgb24_avx2(dst, plane0, plane1, plane2, pixels);
+        case pixel_isa_ssse3:
+            return planar_to_rgb24_ssse3(dst, plane0, plane1, plane2, pixels);
+#endif
+        default:
+            return planar_to_rgb24_scalar(dst, plane0, plane1, plane2, pixels);
+    }
+}
+
+} // namespace xcl
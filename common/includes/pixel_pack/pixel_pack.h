@@ -0,0 +1,72 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+#ifndef PIXEL_PACK_H_
+#define PIXEL_PACK_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace xcl {
+
+/*!
+ * Synopsis:
+ * 1.Converts between packed 3 byte pixels (BMP rows, B G R order), 4 byte
+ *      pixels (the int/uint32_t words of BitmapInterface and bmp_t) and
+ *      three separate 8 bit planes.
+ * 2.Uses SSSE3 or AVX2 byte shuffles when the CPU has them, picked at run
+ *      time, and a scalar loop otherwise; every path gives the same bytes.
+ * 3.Writes straight into the destination, typically the mapping of a device
+ *      buffer, so a frame is prepared for transfer in a single pass.
+ *
+ * Channels are moved as they are, the converters never reorder B G R. Counts
+ * are in pixels; for a BMP with padded rows call them once per row.
+ */
+
+enum pixel_isa { pixel_isa_auto, pixel_isa_scalar, pixel_isa_ssse3, pixel_isa_avx2 };
+
+// Best path this CPU supports, and its name ("avx2", "ssse3" or "scalar").
+// Passing a path to a converter forces it, falling back to the best one
+// available below it; pixel_isa_scalar is the reference implementation.
+pixel_isa pixel_best_isa();
+const char* pixel_isa_name(pixel_isa isa);
+
+// dst[i] = src[3i] | src[3i + 1] << 8 | src[3i + 2] << 16 | alpha << 24.
+// An alpha of 0 gives the words BitmapInterface uses.
+void rgb24_to_rgba32(
+    uint32_t* dst, const unsigned char* src, size_t pixels, uint8_t alpha = 0, pixel_isa isa = pixel_isa_auto);
+
+// Drops the top byte of every word
+void rgba32_to_rgb24(unsigned char* dst, const uint32_t* src, size_t pixels, pixel_isa isa = pixel_isa_auto);
+
+// plane_k[i] = src[3i + k]
+void rgb24_to_planar(unsigned char* plane0,
+                     unsigned char* plane1,
+                     unsigned char* plane2,
+                     const unsigned char* src,
+                     size_t pixels,
+                     pixel_isa isa = pixel_isa_auto);
+
+// dst[3i + k] = plane_k[i]
+void planar_to_rgb24(unsigned char* dst,
+                     const unsigned char* plane0,
+                     const unsigned char* plane1,
+                     const unsigned char* plane2,
+                     size_t pixels,
+                     pixel_isa isa = pixel_isa_auto);
+
+} // namespace xcl
+
+#endif
@@ -0,0 +1,112 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+
+/********************************************************************************************
+ * Description:
+ * Host only benchmark of the pixel converters. Every converter runs on a
+ * frame of random pixels with each path the CPU supports; before timing, the
+ * output of each path is compared with the scalar reference and converted
+ * back to the input, at every length up to 256 pixels and on the full frame.
+ * Rates are in MB of packed 3 byte pixels per second.
+ *
+ * Build and run:
+ *   g++ -O2 -std=c++1y -I../bench pixel_pack_bench.cpp pixel_pack.cpp -o pixel_pack_bench
+ *   ./pixel_pack_bench [width] [height]
+ *
+ * Repetitions and JSON/CSV output follow the XCL_BENCH_* variables of bench.h.
+ ******************************************************************************************/
+
+#include "bench.h"
+#include "pixel_pack.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace xcl;
+
+// Round trips through every converter with the given path, compared with the
+// scalar reference; false on the first mismatch
+static bool check(pixel_isa isa, const std::vector<unsigned char>& rgb, size_t pixels) {
+    std::vector<uint32_t> words(pixels), ref_words(pixels);
+    std::vector<unsigned char> planes(3 * pixels), ref_planes(3 * pixels), back(3 * pixels);
+    unsigned char* p[3] = {planes.data(), planes.data() + pixels, planes.data() + 2 * pixels};
+    unsigned char* r[3] = {ref_planes.data(), ref_planes.data() + pixels, ref_planes.data() + 2 * pixels};
+
+    rgb24_to_rgba32(words.data(), rgb.data(), pixels, 0xff, isa);
+    rgb24_to_rgba32(ref_words.data(), rgb.data(), pixels, 0xff, pixel_isa_scalar);
+    if (words != ref_words) return false;
+    rgba32_to_rgb24(back.data(), words.data(), pixels, isa);
+    if (memcmp(back.data(), rgb.data(), back.size()) != 0) return false;
+
+    rgb24_to_planar(p[0], p[1], p[2], rgb.data(), pixels, isa);
+    rgb24_to_planar(r[0], r[1], r[2], rgb.data(), pixels, pixel_isa_scalar);
+    if (planes != ref_planes) return false;
+    planar_to_rgb24(back.data(), p[0], p[1], p[2], pixels, isa);
+    return memcmp(back.data(), rgb.data(), back.size()) == 0;
+}
+
+int main(int argc, char* argv[]) {
+    int width = argc > 1 ? atoi(argv[1]) : 3840;
+    int height = argc > 2 ? atoi(argv[2]) : 2160;
+    if (width <= 0 || height <= 0) {
+        printf("Usage: %s [width] [height]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    size_t pixels = (size_t)width * height;
+    std::vector<unsigned char> rgb(3 * pixels);
+    for (auto& c : rgb) c = rand();
+
+    std::vector<pixel_isa> paths = {pixel_isa_scalar};
+    if (pixel_best_isa() >= pixel_isa_ssse3) paths.push_back(pixel_isa_ssse3);
+    if (pixel_best_isa() >= pixel_isa_avx2) paths.push_back(pixel_isa_avx2);
+
+    for (pixel_isa isa : paths) {
+        bool ok = check(isa, rgb, pixels);
+        for (size_t n = 0; n <= 256 && ok; n++) {
+            ok = check(isa, std::vector<unsigned char>(rgb.begin(), rgb.begin() + 3 * n), n);
+        }
+        if (!ok) {
+            printf("%s path does not match the scalar reference\n", pixel_isa_name(isa));
+            return EXIT_FAILURE;
+        }
+    }
+    printf("%dx%d frame, paths match the scalar reference, best path %s\n", width, height,
+           pixel_isa_name(pixel_isa_auto));
+
+    xcl::benchmark bench("pixel_pack", bench_options().from_env());
+    double megabytes = 3.0 * pixels / 1e6;
+    std::vector<uint32_t> words(pixels);
+    std::vector<unsigned char> planes(3 * pixels), back(3 * pixels);
+    unsigned char* p[3] = {planes.data(), planes.data() + pixels, planes.data() + 2 * pixels};
+    rgb24_to_rgba32(words.data(), rgb.data(), pixels);
+
+    for (pixel_isa isa : paths) {
+        std::string name = pixel_isa_name(isa);
+        bench.run("rgb24_to_rgba32 " + name, [&] { rgb24_to_rgba32(words.data(), rgb.data(), pixels, 0, isa); },
+                  megabytes, "MB/s");
+        bench.run("rgba32_to_rgb24 " + name, [&] { rgba32_to_rgb24(back.data(), words.data(), pixels, isa); },
+                  megabytes, "MB/s");
+        bench.run("rgb24_to_planar " + name, [&] { rgb24_to_planar(p[0], p[1], p[2], rgb.data(), pixels, isa); },
+                  megabytes, "MB/s");
+        bench.run("planar_to_rgb24 " + name, [&] { planar_to_rgb24(back.data(), p[0], p[1], p[2], pixels, isa); },
+                  megabytes, "MB/s");
+    }
+    bench.print_summary();
+    bench.save();
+    return EXIT_SUCCESS;
+}
@@ -18,6 +18,84 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+// Header fields are little endian and packed, the struct is neither, so the
+// 54 header bytes go through one buffer instead of one call per field
+static void put(unsigned char*& p, uint32_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) *p++ = (value >> (8 * i)) & 0xff;
+}
+
+static uint32_t get(const unsigned char*& p, int bytes) {
+    uint32_t value = 0;
+    for (int i = 0; i < bytes; i++) value |= (uint32_t)*p++ << (8 * i);
+    return value;
+}
+
+static void packheader(const struct bmpheader_t* h, unsigned char* raw) {
+    unsigned char* p = raw;
+    put(p, h->headerB, 1);
+    put(p, h->headerM, 1);
+    put(p, h->headerbmpsize, 4);
+    put(p, h->headerapp0, 2);
+    put(p, h->headerapp1, 2);
+    put(p, h->headerpixelsoffset, 4);
+    put(p, h->dibheadersize, 4);
+    put(p, h->dibwidth, 4);
+    put(p, h->dibheight, 4);
+    put(p, h->dibplane, 2);
+    put(p, h->dibdepth, 2);
+    put(p, h->dibcompression, 4);
+    put(p, h->dibsize, 4);
+    put(p, h->dibhor, 4);
+    put(p, h->dibver, 4);
+    put(p, h->dibpal, 4);
+    put(p, h->dibimportant, 4);
+}
+
+static void unpackheader(const unsigned char* raw, struct bmpheader_t* h) {
+    const unsigned char* p = raw;
+    h->headerB = get(p, 1);
+    h->headerM = get(p, 1);
+    h->headerbmpsize = get(p, 4);
+    h->headerapp0 = get(p, 2);
+    h->headerapp1 = get(p, 2);
+    h->headerpixelsoffset = get(p, 4);
+    h->dibheadersize = get(p, 4);
+    h->dibwidth = get(p, 4);
+    h->dibheight = get(p, 4);
+    h->dibplane = get(p, 2);
+    h->dibdepth = get(p, 2);
+    h->dibcompression = get(p, 4);
+    h->dibsize = get(p, 4);
+    h->dibhor = get(p, 4);
+    h->dibver = get(p, 4);
+    h->dibpal = get(p, 4);
+    h->dibimportant = get(p, 4);
+}
+
+static int validateheader(struct bmp_t* bitmap) {
+    // header
+    if (bitmap->header.headerB != 'B') return -2;
+    if (bitmap->header.headerM != 'M') return -2;
+    // headerbmpsize
+    if (bitmap->header.headerapp0 != 0) return -2;
+    if (bitmap->header.headerapp1 != 0) return -2;
+    if (bitmap->header.headerpixelsoffset != 54) return -2;
+    // dib header
+    if (bitmap->header.dibheadersize != 40) return -2;
+    bitmap->width = bitmap->header.dibwidth;
+    bitmap->height = bitmap->header.dibheight;
+    if (bitmap->header.dibplane != 1) return -2;
+    if (bitmap->header.dibdepth != 24) return -2;
+    if (bitmap->header.dibcompression != 0) return -2;
+    if (bitmap->header.dibsize != (bitmap->header.dibwidth * bitmap->header.dibheight * 3)) return -2;
+    // dibsize do nothing yet
+    // dibhor unused
+    // dibver unused
+    if (bitmap->header.dibpal != 0) return -2;
+    if (bitmap->header.dibimportant != 0) return -2;
+    return 0;
+}
+
 int writebmp(char* filename, struct bmp_t* bitmap) {
     // 24 bpp uncompressed
 
@@ -45,33 +123,16 @@ int writebmp(char* filename, struct bmp_t* bitmap) {
     bitmap->header.headerapp0 = 0;
     bitmap->header.headerapp1 = 0;
 
-    // write header
-    fwrite(&(bitmap->header.headerB), 1, 1, fp);
-    fwrite(&(bitmap->header.headerM), 1, 1, fp);
-    fwrite(&(bitmap->header.headerbmpsize), 4, 1, fp);
-    fwrite(&(bitmap->header.headerapp0), 2, 1, fp);
-    fwrite(&(bitmap->header.headerapp1), 2, 1, fp);
-    fwrite(&(bitmap->header.headerpixelsoffset), 4, 1, fp);
-
-    // write dib header
-    fwrite(&(bitmap->header.dibheadersize), 4, 1, fp);
-    fwrite(&(bitmap->header.dibwidth), 4, 1, fp);
-    fwrite(&(bitmap->header.dibheight), 4, 1, fp);
-    fwrite(&(bitmap->header.dibplane), 2, 1, fp);
-    fwrite(&(bitmap->header.dibdepth), 2, 1, fp);
-    fwrite(&(bitmap->header.dibcompression), 4, 1, fp);
-    fwrite(&(bitmap->header.dibsize), 4, 1, fp);
-    fwrite(&(bitmap->header.dibhor), 4, 1, fp);
-    fwrite(&(bitmap->header.dibver), 4, 1, fp);
-    fwrite(&(bitmap->header.dibpal), 4, 1, fp);
-    fwrite(&(bitmap->header.dibimportant), 4, 1, fp);
+    // write header and dib header
+    unsigned char raw[54];
+    packheader(&bitmap->header, raw);
+    fwrite(raw, sizeof(raw), 1, fp);
 
     // write pixels
     fwrite(bitmap->pixels, bitmap->header.dibsize, 1, fp);
 
-    if (ferror(fp)) return -1;
-
-    fclose(fp);
+    int error = ferror(fp);
+    if (fclose(fp) != 0 || error) return -1;
     return 0;
 }
 
@@ -82,56 +143,33 @@ int readbmp(char* filename, struct bmp_t* bitmap) {
     FILE* fp = fopen(filename, "r+b");
     if (fp == nullptr) return -1;
 
-    // read header
-    fread(&(bitmap->header.headerB), 1, 1, fp);
-    fread(&(bitmap->header.headerM), 1, 1, fp);
-    fread(&(bitmap->header.headerbmpsize), 4, 1, fp);
-    fread(&(bitmap->header.headerapp0), 2, 1, fp);
-    fread(&(bitmap->header.headerapp1), 2, 1, fp);
-    fread(&(bitmap->header.headerpixelsoffset), 4, 1, fp);
-    // read dib header
-    fread(&(bitmap->header.dibheadersize), 4, 1, fp);
-    fread(&(bitmap->header.dibwidth), 4, 1, fp);
-    fread(&(bitmap->header.dibheight), 4, 1, fp);
-    fread(&(bitmap->header.dibplane), 2, 1, fp);
-    fread(&(bitmap->header.dibdepth), 2, 1, fp);
-    fread(&(bitmap->header.dibcompression), 4, 1, fp);
-    fread(&(bitmap->header.dibsize), 4, 1, fp);
-    fread(&(bitmap->header.dibhor), 4, 1, fp);
-    fread(&(bitmap->header.dibver), 4, 1, fp);
-    fread(&(bitmap->header.dibpal), 4, 1, fp);
-    fread(&(bitmap->header.dibimportant), 4, 1, fp);
-
-    if (ferror(fp)) return -1;
+    // read header and dib header
+    unsigned char raw[54];
+    if (fread(raw, sizeof(raw), 1, fp) != 1) {
+        fclose(fp);
+        return -1;
+    }
+    unpackheader(raw, &bitmap->header);
 
     // validate header
-    // header
-    if (bitmap->header.headerB != 'B') return -2;
-    if (bitmap->header.headerM != 'M') return -2;
-    // headerbmpsize
-    if (bitmap->header.headerapp0 != 0) return -2;
-    if (bitmap->header.headerapp1 != 0) return -2;
-    if (bitmap->header.headerpixelsoffset != 54) return -2;
-    // dib header
-    if (bitmap->header.dibheadersize != 40) return -2;
-    bitmap->width = bitmap->header.dibwidth;
-    bitmap->height = bitmap->header.dibheight;
-    if (bitmap->header.dibplane != 1) return -2;
-    if (bitmap->header.dibdepth != 24) return -2;
-    if (bitmap->header.dibcompression != 0) return -2;
-    if (bitmap->header.dibsize != (bitmap->header.dibwidth * bitmap->header.dibheight * 3)) return -2;
-    // dibsize do nothing yet
-    // dibhor unused
-    // dibver unused
-    if (bitmap->header.dibpal != 0) return -2;
-    if (bitmap->header.dibimportant != 0) return -2;
+    int status = validateheader(bitmap);
+    if (status != 0) {
+        fclose(fp);
+        return status;
+    }
 
     // read pixels
     bitmap->pixels = (uint32_t*)malloc(bitmap->header.dibsize);
-    if (bitmap->pixels == nullptr) return -3;
-    fread(bitmap->pixels, bitmap->header.dibsize, 1, fp);
-
-    if (ferror(fp)) return -1;
+    if (bitmap->pixels == nullptr) {
+        fclose(fp);
+        return -3;
+    }
+    if (fread(bitmap->pixels, bitmap->header.dibsize, 1, fp) != 1) {
+        free(bitmap->pixels);
+        bitmap->pixels = nullptr;
+        fclose(fp);
+        return -1;
+    }
 
     fclose(fp);
     return 0;
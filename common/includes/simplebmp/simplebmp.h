@@ -20,6 +20,8 @@
 #ifndef __SIMPLE_BMP
 #define __SIMPLE_BMP
 
+#include <stdint.h>
+
 struct bmpheader_t {
     // Header
     char headerB;
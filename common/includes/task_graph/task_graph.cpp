@@ -0,0 +1,223 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+
+#include "task_graph.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+
+namespace xcl {
+
+task_graph::node task_graph::add(std::function<void()> work, const std::string& name) {
+    task t;
+    t.name = name;
+    t.work = std::move(work);
+    m_tasks.push_back(std::move(t));
+    return m_tasks.size() - 1;
+}
+
+task_graph::node task_graph::add_sync(
+    const xrt::bo& bo, xclBOSyncDirection dir, const std::string& name, size_t size, size_t offset) {
+    xrt::bo buffer = bo;
+    return add(
+        [buffer, dir, size, offset]() mutable {
+            if (size == 0)
+                buffer.sync(dir);
+            else
+                buffer.sync(dir, size, offset);
+        },
+        name);
+}
+
+task_graph::node task_graph::add_run(const xrt::run& run, const std::string& name) {
+    xrt::run r = run;
+    return add(
+        [r]() mutable {
+            r.start();
+            r.wait();
+        },
+        name);
+}
+
+task_graph::node task_graph::add_runs(const std::vector<xrt::run>& runs, const std::string& name) {
+    std::vector<xrt::run> rs = runs;
+    return add(
+        [rs]() mutable {
+            for (auto& r : rs) r.start();
+            for (auto& r : rs) r.wait();
+        },
+        name);
+}
+
+task_graph::node task_graph::add_host(std::function<void()> fn, const std::string& name) {
+    return add(std::move(fn), name);
+}
+
+void task_graph::depends(node after, node before) {
+    if (after >= m_tasks.size() || before >= m_tasks.size()) {
+        printf("task_graph: edge %zu -> %zu names a node that does not exist (%zu nodes)\n", before, after,
+               m_tasks.size());
+        exit(EXIT_FAILURE);
+    }
+    std::vector<node>& pred = m_tasks[after].pred;
+    if (std::find(pred.begin(), pred.end(), before) != pred.end()) return;
+    pred.push_back(before);
+    m_tasks[before].succ.push_back(after);
+}
+
+void task_graph::depends(node after, std::initializer_list<node> before) {
+    for (node b : before) depends(after, b);
+}
+
+std::vector<task_graph::node> task_graph::topological_order() const {
+    std::vector<size_t> waiting_on(m_tasks.size());
+    std::vector<node> order;
+    for (node n = 0; n < m_tasks.size(); n++) {
+        waiting_on[n] = m_tasks[n].pred.size();
+        if (waiting_on[n] == 0) order.push_back(n);
+    }
+    for (size_t i = 0; i < order.size(); i++) {
+        for (node s : m_tasks[order[i]].succ) {
+            if (--waiting_on[s] == 0) order.push_back(s);
+        }
+    }
+    if (order.size() != m_tasks.size()) {
+        printf("task_graph: %zu of %zu nodes are on a dependency cycle\n", m_tasks.size() - order.size(),
+               m_tasks.size());
+        exit(EXIT_FAILURE);
+    }
+    return order;
+}
+
+void task_report::print(const task_graph& graph, std::ostream& out) const {
+    out << std::fixed << std::setprecision(3);
+    out << std::left << std::setw(24) << "Node" << std::right << std::setw(7) << "Queue" << std::setw(12)
+        << "Start(ms)" << std::setw(12) << "End(ms)" << "\n";
+    for (task_graph::node n = 0; n < times.size(); n++) {
+        bool critical = std::find(critical_path.begin(), critical_path.end(), n) != critical_path.end();
+        out << std::left << std::setw(24) << graph.name(n) << std::right << std::setw(7) << times[n].queue
+            << std::setw(12) << times[n].start << std::setw(12) << times[n].end
+            << (times[n].skipped ? "  skipped" : critical ? "  *" : "") << "\n";
+    }
+    out << "wall " << wall_ms << " ms, busy " << busy_ms << " ms, critical path " << critical_ms << " ms, overlap "
+        << overlap() << "\n";
+    out.unsetf(std::ios_base::floatfield);
+    out << std::setprecision(6);
+}
+
+task_executor::task_executor(unsigned queues) : m_graph(nullptr), m_remaining(0) {
+    if (queues == 0) {
+        printf("task_executor: needs at least one queue\n");
+        exit(EXIT_FAILURE);
+    }
+    for (unsigned q = 0; q < queues; q++) m_queues.emplace_back(new xrt::queue());
+    m_queued.assign(queues, 0);
+}
+
+// Called with m_mutex held
+void task_executor::dispatch(task_graph::node n) {
+    unsigned q = static_cast<unsigned>(std::min_element(m_queued.begin(), m_queued.end()) - m_queued.begin());
+    m_queued[q]++;
+    m_queues[q]->enqueue([this, n, q] {
+        bool skip;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            skip = m_error != nullptr;
+        }
+        double start = std::chrono::duration<double, std::milli>(clock::now() - m_start).count();
+        if (!skip) {
+            try {
+                m_graph->m_tasks[n].work();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_error) m_error = std::current_exception();
+            }
+        }
+        double end = std::chrono::duration<double, std::milli>(clock::now() - m_start).count();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_times[n] = {start, skip ? start : end, q, skip};
+        complete(n, q);
+    });
+}
+
+// Called with m_mutex held
+void task_executor::complete(task_graph::node n, unsigned queue) {
+    m_queued[queue]--;
+    for (task_graph::node s : m_graph->m_tasks[n].succ) {
+        if (--m_waiting_on[s] == 0) dispatch(s);
+    }
+    if (--m_remaining == 0) m_done.notify_all();
+}
+
+task_report task_executor::execute(const task_graph& graph) {
+    std::vector<task_graph::node> order = graph.topological_order();
+    size_t nodes = graph.size();
+
+    task_report report;
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_graph = &graph;
+        m_times.assign(nodes, task_times{0, 0, 0, false});
+        m_waiting_on.resize(nodes);
+        for (task_graph::node n = 0; n < nodes; n++) m_waiting_on[n] = graph.predecessors(n).size();
+        m_remaining = nodes;
+        m_error = nullptr;
+        m_start = clock::now();
+        for (task_graph::node n = 0; n < nodes; n++) {
+            if (m_waiting_on[n] == 0) dispatch(n);
+        }
+        m_done.wait(lock, [this] { return m_remaining == 0; });
+        report.times = m_times;
+        error = m_error;
+        m_graph = nullptr;
+    }
+
+    // Longest chain of measured durations, walking the nodes in dependency
+    // order so every predecessor is finished before its successors
+    std::vector<double> finish(nodes, 0);
+    std::vector<size_t> via(nodes, nodes);
+    report.wall_ms = 0;
+    report.busy_ms = 0;
+    report.critical_ms = 0;
+    size_t last = nodes;
+    for (task_graph::node n : order) {
+        double duration = report.times[n].end - report.times[n].start;
+        double ready = 0;
+        for (task_graph::node p : graph.predecessors(n)) {
+            if (via[n] == nodes || finish[p] > ready) {
+                ready = finish[p];
+                via[n] = p;
+            }
+        }
+        finish[n] = ready + duration;
+        report.busy_ms += duration;
+        report.wall_ms = std::max(report.wall_ms, report.times[n].end);
+        if (last == nodes || finish[n] > report.critical_ms) {
+            report.critical_ms = finish[n];
+            last = n;
+        }
+    }
+    for (size_t n = last; n != nodes; n = via[n]) report.critical_path.push_back(n);
+    std::reverse(report.critical_path.begin(), report.critical_path.end());
+
+    if (error) std::rethrow_exception(error);
+    return report;
+}
+
+} // namespace xcl
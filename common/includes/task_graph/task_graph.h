@@ -0,0 +1,153 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+#ifndef TASK_GRAPH_H_
+#define TASK_GRAPH_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "experimental/xrt_bo.h"
+#include "experimental/xrt_kernel.h"
+#include "experimental/xrt_queue.h"
+
+namespace xcl {
+
+/*!
+ * Synopsis:
+ * 1.A task_graph holds the work of one transfer/compute/readback pipeline as
+ *      nodes: buffer syncs, kernel runs and host callbacks.
+ * 2.Edges say which nodes have to complete before another one may start.
+ * 3.The graph only describes the work; a task_executor runs it, and the same
+ *      graph can be run any number of times.
+ *
+ * Kernel runs are prepared by the caller (arguments set, not started). A node
+ * made of several runs starts all of them before waiting for any, which is
+ * what kernels connected by AXI streams need.
+ */
+class task_graph {
+   public:
+    typedef size_t node;
+
+    // size 0 syncs the whole buffer
+    node add_sync(const xrt::bo& bo,
+                  xclBOSyncDirection dir,
+                  const std::string& name,
+                  size_t size = 0,
+                  size_t offset = 0);
+    node add_run(const xrt::run& run, const std::string& name);
+    node add_runs(const std::vector<xrt::run>& runs, const std::string& name);
+    node add_host(std::function<void()> fn, const std::string& name);
+
+    // after does not start before every node in before has completed
+    void depends(node after, node before);
+    void depends(node after, std::initializer_list<node> before);
+
+    size_t size() const { return m_tasks.size(); }
+    const std::string& name(node n) const { return m_tasks[n].name; }
+    const std::vector<node>& predecessors(node n) const { return m_tasks[n].pred; }
+    const std::vector<node>& successors(node n) const { return m_tasks[n].succ; }
+
+    // Nodes in an order where each comes after its predecessors; exits when
+    // the edges form a cycle
+    std::vector<node> topological_order() const;
+
+   private:
+    friend class task_executor;
+
+    struct task {
+        std::string name;
+        std::function<void()> work;
+        std::vector<node> pred;
+        std::vector<node> succ;
+    };
+
+    node add(std::function<void()> work, const std::string& name);
+
+    std::vector<task> m_tasks;
+};
+
+struct task_times {
+    double start; // ms since the graph was started
+    double end;
+    unsigned queue;
+    bool skipped; // not run because an earlier node failed
+};
+
+struct task_report {
+    double wall_ms;     // first node start to last node end, as seen by the host
+    double busy_ms;     // sum of every node's duration, the serial time of the graph
+    double critical_ms; // longest dependency chain, measured node durations
+    std::vector<task_graph::node> critical_path;
+    std::vector<task_times> times;
+
+    // busy / wall, how many nodes were in progress on average
+    double overlap() const { return wall_ms > 0 ? busy_ms / wall_ms : 0; }
+    void print(const task_graph& graph, std::ostream& out) const;
+};
+
+/*!
+ * Runs task_graphs on a pool of xrt::queues. A node is handed to a queue only
+ * once all its predecessors have completed, and it goes to the queue with the
+ * fewest nodes waiting, so independent syncs and runs overlap across queues.
+ * One queue runs the graph serially in dependency order.
+ *
+ * execute() is not reentrant: run one graph at a time per executor.
+ */
+class task_executor {
+   public:
+    explicit task_executor(unsigned queues);
+
+    task_executor(const task_executor&) = delete;
+    task_executor& operator=(const task_executor&) = delete;
+
+    // Blocks until every node has completed. If a node throws, nodes that
+    // have not started yet are skipped and the first exception is rethrown
+    // once the queues are idle.
+    task_report execute(const task_graph& graph);
+
+    unsigned queues() const { return static_cast<unsigned>(m_queues.size()); }
+
+   private:
+    typedef std::chrono::steady_clock clock;
+
+    void dispatch(task_graph::node n);
+    void complete(task_graph::node n, unsigned queue);
+
+    std::vector<std::unique_ptr<xrt::queue>> m_queues;
+    std::vector<size_t> m_queued; // nodes handed to each queue and not completed
+
+    const task_graph* m_graph;
+    clock::time_point m_start;
+    std::vector<size_t> m_waiting_on; // predecessors not completed yet, per node
+    std::vector<task_times> m_times;
+    size_t m_remaining;
+    std::exception_ptr m_error;
+    std::mutex m_mutex;
+    std::condition_variable m_done;
+};
+
+} // namespace xcl
+
+#endif
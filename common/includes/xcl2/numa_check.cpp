@@ -0,0 +1,98 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+
+/********************************************************************************************
+ * Description:
+ * Host only check of the NUMA topology helpers of xcl2 against a fake sysfs
+ * tree. The tree is built in a temporary directory with the numa_node file
+ * of two PCIe functions and the cpulist of two nodes, then the helpers are
+ * pointed at it both through their sysfs_root argument and through
+ * XCL_SYSFS_ROOT. No device is opened.
+ *
+ * Build and run:
+ *   g++ -std=c++1y -pthread -I$XILINX_XRT/include numa_check.cpp xcl2.cpp \
+ *       -L$XILINX_XRT/lib -lOpenCL -o numa_check
+ *   ./numa_check
+ *
+ ******************************************************************************************/
+
+#include "xcl2.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+static bool check(bool ok, const char* what) {
+    if (!ok) printf("FAILED: %s\n", what);
+    return ok;
+}
+
+static void make_dirs(const std::string& path) {
+    for (size_t pos = path.find('/', 1); pos != std::string::npos; pos = path.find('/', pos + 1)) {
+        mkdir(path.substr(0, pos).c_str(), 0755);
+    }
+    mkdir(path.c_str(), 0755);
+}
+
+static void write_file(const std::string& dir, const std::string& name, const std::string& content) {
+    make_dirs(dir);
+    std::ofstream file(dir + "/" + name);
+    file << content << "\n";
+}
+
+int main() {
+    char root_template[] = "/tmp/numa_check.XXXXXX";
+    if (mkdtemp(root_template) == nullptr) {
+        printf("Cannot create a temporary directory\n");
+        return EXIT_FAILURE;
+    }
+    std::string root = root_template;
+    write_file(root + "/bus/pci/devices/0000:af:00.1", "numa_node", "1");
+    // Platforms without NUMA information report -1
+    write_file(root + "/bus/pci/devices/0000:17:00.1", "numa_node", "-1");
+    write_file(root + "/devices/system/node/node0", "cpulist", "0-3,8-11");
+    write_file(root + "/devices/system/node/node1", "cpulist", "4-7,12");
+
+    bool ok = true;
+    ok &= check(xcl::get_numa_node("0000:af:00.1", root) == 1, "node of a full BDF");
+    // CL_DEVICE_PCIE_BDF may omit the domain and use upper case
+    ok &= check(xcl::get_numa_node("af:00.1", root) == 1, "node of a BDF without domain");
+    ok &= check(xcl::get_numa_node("AF:00.1", root) == 1, "node of an upper case BDF");
+    ok &= check(xcl::get_numa_node("0000:17:00.1", root) == -1, "node reported as -1");
+    ok &= check(xcl::get_numa_node("0000:b3:00.1", root) == -1, "node of a missing function");
+
+    ok &= check(xcl::get_node_cpus(0, root) == std::vector<int>({0, 1, 2, 3, 8, 9, 10, 11}), "cpulist of node 0");
+    ok &= check(xcl::get_node_cpus(1, root) == std::vector<int>({4, 5, 6, 7, 12}), "cpulist of node 1");
+    ok &= check(xcl::get_node_cpus(2, root).empty(), "cpulist of a missing node");
+    ok &= check(xcl::get_node_cpus(-1, root).empty(), "cpulist of node -1");
+    ok &= check(xcl::parse_cpu_list("").empty(), "empty cpulist");
+    ok &= check(!xcl::bind_thread_to_node(2, root), "binding to a missing node fails");
+
+    // The default root follows XCL_SYSFS_ROOT
+    setenv("XCL_SYSFS_ROOT", root.c_str(), 1);
+    ok &= check(xcl::default_sysfs_root() == root, "XCL_SYSFS_ROOT is the default root");
+    ok &= check(xcl::get_numa_node("0000:af:00.1") == 1, "node through XCL_SYSFS_ROOT");
+    unsetenv("XCL_SYSFS_ROOT");
+    ok &= check(xcl::default_sysfs_root() == "/sys", "/sys without XCL_SYSFS_ROOT");
+
+    std::string cleanup = "rm -rf " + root;
+    if (system(cleanup.c_str()) != 0) printf("Cannot remove %s\n", root.c_str());
+
+    std::cout << "TEST " << (ok ? "PASSED" : "FAILED") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
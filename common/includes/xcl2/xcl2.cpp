@@ -15,15 +15,30 @@
 */
 
 #include "xcl2.hpp"
+#include "xclbin.h"
+#include <chrono>
+#include <algorithm>
+#include <atomic>
 #include <climits>
+#include <cstring>
+#include <fcntl.h>
 #include <sys/stat.h>
 #include <string>
 #include <iomanip>
 #include <sstream>
+#include <thread>
 #if defined(_WINDOWS)
 #include <io.h>
 #else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 #include <unistd.h>
+#if defined(MAP_HUGE_SHIFT) && !defined(MAP_HUGE_2MB)
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
 #endif
 
 namespace xcl {
@@ -104,16 +119,107 @@ cl_device_id find_device_bdf_c(cl_device_id* devices, const std::string& bdf, cl
     }
     return device;
 }
+std::vector<int> parse_cpu_list(const std::string& cpu_list) {
+    std::vector<int> cpus;
+    std::stringstream list(cpu_list);
+    std::string range;
+    while (std::getline(list, range, ',')) {
+        if (range.empty() || !isdigit(range[0])) continue;
+        size_t dash = range.find('-');
+        int first = atoi(range.c_str());
+        int last = (dash == std::string::npos) ? first : atoi(range.c_str() + dash + 1);
+        for (int cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+std::string default_sysfs_root() {
+    const char* root = getenv("XCL_SYSFS_ROOT");
+    return (root != nullptr && root[0] != '\0') ? root : "/sys";
+}
+
+int get_numa_node(const std::string& bdf, const std::string& sysfs_root) {
+    // CL_DEVICE_PCIE_BDF may omit the PCI domain
+    std::string full_bdf = bdf;
+    if (std::count(full_bdf.begin(), full_bdf.end(), ':') == 1) full_bdf = "0000:" + full_bdf;
+    std::transform(full_bdf.begin(), full_bdf.end(), full_bdf.begin(), ::tolower);
+
+    std::ifstream node_file(sysfs_root + "/bus/pci/devices/" + full_bdf + "/numa_node");
+    int node = -1;
+    if (!(node_file >> node)) return -1;
+    return node;
+}
+
+int get_numa_node(const cl::Device& device, const std::string& sysfs_root) {
+    char device_bdf[20];
+    cl_int err = device.getInfo(CL_DEVICE_PCIE_BDF, &device_bdf);
+    if (err != CL_SUCCESS) return -1;
+    return get_numa_node(std::string(device_bdf), sysfs_root);
+}
+
+std::vector<int> get_node_cpus(int node, const std::string& sysfs_root) {
+    if (node < 0) return std::vector<int>();
+    std::ifstream cpulist_file(sysfs_root + "/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string cpu_list;
+    std::getline(cpulist_file, cpu_list);
+    return parse_cpu_list(cpu_list);
+}
+
+bool bind_thread_to_node(int node, const std::string& sysfs_root) {
+    auto cpus = get_node_cpus(node, sysfs_root);
+    if (cpus.empty()) return false;
+#if defined(_WINDOWS)
+    return false;
+#else
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (auto cpu : cpus) {
+        if (cpu < CPU_SETSIZE) CPU_SET(cpu, &cpu_set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0;
+#endif
+}
+
+void* alloc_on_node(size_t bytes, int node) {
+    size_t length = bytes ? bytes : 1;
+#if defined(_WINDOWS)
+    return _aligned_malloc(length, 4096);
+#else
+    void* ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) return nullptr;
+    if (node >= 0) {
+        // MPOL_BIND from <linux/mempolicy.h>; called through syscall() to
+        // avoid a libnuma dependency.
+        const int mpol_bind = 2;
+        const unsigned long bits = 8 * sizeof(unsigned long);
+        std::vector<unsigned long> node_mask(node / bits + 1, 0);
+        node_mask[node / bits] |= 1UL << (node % bits);
+        if (syscall(SYS_mbind, ptr, length, mpol_bind, node_mask.data(), node_mask.size() * bits + 1, 0) != 0) {
+            std::cout << "WARNING: Unable to bind host buffer to NUMA node " << node << std::endl;
+        }
+    }
+    return ptr;
+#endif
+}
+
+void free_on_node(void* ptr, size_t bytes) {
+    if (ptr == nullptr) return;
+#if defined(_WINDOWS)
+    _aligned_free(ptr);
+#else
+    munmap(ptr, bytes ? bytes : 1);
+#endif
+}
+
 std::vector<unsigned char> read_binary_file(const std::string& xclbin_file_name) {
     std::cout << "INFO: Reading " << xclbin_file_name << std::endl;
-    FILE* fp;
-    if ((fp = fopen(xclbin_file_name.c_str(), "r")) == nullptr) {
+    std::ifstream bin_file(xclbin_file_name.c_str(), std::ifstream::binary);
+    if (!bin_file.is_open()) {
         printf("ERROR: %s xclbin not available please build\n", xclbin_file_name.c_str());
         exit(EXIT_FAILURE);
     }
     // Loading XCL Bin into char buffer
     std::cout << "Loading: '" << xclbin_file_name.c_str() << "'\n";
-    std::ifstream bin_file(xclbin_file_name.c_str(), std::ifstream::binary);
     bin_file.seekg(0, bin_file.end);
     auto nb = bin_file.tellg();
     bin_file.seekg(0, bin_file.beg);
@@ -123,6 +229,471 @@ std::vector<unsigned char> read_binary_file(const std::string& xclbin_file_name)
     return buf;
 }
 
+binary_file::binary_file(const std::string& xclbin_file_name)
+    : m_name(xclbin_file_name), m_data(nullptr), m_size(0) {
+    std::cout << "INFO: Mapping " << xclbin_file_name << std::endl;
+#if defined(_WINDOWS)
+    // No mmap on this host, fall back to a private copy of the file
+    auto buf = read_binary_file(xclbin_file_name);
+    m_size = buf.size();
+    m_data = reinterpret_cast<unsigned char*>(malloc(m_size));
+    memcpy(m_data, buf.data(), m_size);
+#else
+    int fd = open(xclbin_file_name.c_str(), O_RDONLY);
+    if (fd < 0) {
+        printf("ERROR: %s xclbin not available please build\n", xclbin_file_name.c_str());
+        exit(EXIT_FAILURE);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        printf("ERROR: Unable to stat %s\n", xclbin_file_name.c_str());
+        close(fd);
+        exit(EXIT_FAILURE);
+    }
+    m_size = st.st_size;
+    void* addr = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping holds its own reference to the file
+    close(fd);
+    if (addr == MAP_FAILED) {
+        printf("ERROR: Unable to map %s\n", xclbin_file_name.c_str());
+        exit(EXIT_FAILURE);
+    }
+    m_data = reinterpret_cast<unsigned char*>(addr);
+    // binaries() hands the whole image to cl::Program, which reads it front
+    // to back; the few metadata pages touched before that are cheap either way.
+    madvise(addr, m_size, MADV_SEQUENTIAL);
+#endif
+}
+
+binary_file::~binary_file() {
+#if defined(_WINDOWS)
+    free(m_data);
+#else
+    if (m_data != nullptr) munmap(m_data, m_size);
+#endif
+}
+
+bool binary_file::is_axlf() const {
+    return m_size >= sizeof(axlf) && memcmp(m_data, "xclbin2", 8) == 0;
+}
+
+void binary_file::index_sections() const {
+    if (!is_axlf()) return;
+    auto bin = top();
+    uint32_t count = bin->m_header.m_numSections;
+    // axlf already embeds the first section header
+    size_t table_end = sizeof(axlf) + (count ? count - 1 : 0) * sizeof(axlf_section_header);
+    if (table_end > m_size) {
+        std::cout << "WARNING: " << m_name << " has a truncated section table" << std::endl;
+        return;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        const axlf_section_header& hdr = bin->m_sections[i];
+        // Written so that offset + size cannot wrap around
+        if (hdr.m_sectionOffset > m_size || hdr.m_sectionSize > m_size - hdr.m_sectionOffset) continue;
+        // Keep the first section of each kind, matching xclbin::get_axlf_section()
+        m_sections.insert(std::make_pair(static_cast<int>(hdr.m_sectionKind),
+                                         std::make_pair(hdr.m_sectionOffset, hdr.m_sectionSize)));
+    }
+}
+
+const unsigned char* binary_file::section(int kind, size_t* section_size) const {
+    std::call_once(m_indexed, [this] { index_sections(); });
+    auto it = m_sections.find(kind);
+    if (it == m_sections.end()) {
+        if (section_size) *section_size = 0;
+        return nullptr;
+    }
+    if (section_size) *section_size = it->second.second;
+    return m_data + it->second.first;
+}
+
+std::string binary_file::uuid() const {
+    if (!is_axlf()) return "";
+    const unsigned char* id = top()->m_header.uuid;
+    std::stringstream stream;
+    stream << std::hex << std::setfill('0');
+    for (int i = 0; i < 16; i++) {
+        if (i == 4 || i == 6 || i == 8 || i == 10) stream << "-";
+        stream << std::setw(2) << static_cast<unsigned int>(id[i]);
+    }
+    return stream.str();
+}
+
+program_cache& program_cache::instance() {
+    static program_cache cache;
+    return cache;
+}
+
+std::shared_ptr<program_cache::entry> program_cache::get(const cl::Device& device,
+                                                         const binary_file& xclbin,
+                                                         cl_int* err) {
+    std::string uuid = xclbin.uuid();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(device());
+    if (it != m_entries.end()) {
+        // An empty UUID means the image could not be identified, never reuse it
+        if (!uuid.empty() && it->second->uuid == uuid) {
+            m_hits++;
+            if (err) *err = CL_SUCCESS;
+            return it->second;
+        }
+        // The device is about to be reprogrammed, release the old image
+        m_entries.erase(it);
+    }
+
+    m_misses++;
+    cl_int status;
+    auto program = std::make_shared<entry>();
+    program->uuid = uuid;
+    program->device = device;
+    auto start = std::chrono::high_resolution_clock::now();
+    program->context = cl::Context(device, nullptr, nullptr, nullptr, &status);
+    if (status == CL_SUCCESS) {
+        program->program = cl::Program(program->context, {device}, xclbin.binaries(), nullptr, &status);
+    }
+    m_load_time_ms +=
+        std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    if (err) *err = status;
+    if (status != CL_SUCCESS) return nullptr;
+    m_entries[device()] = program;
+    return program;
+}
+
+cl::Kernel program_cache::get_kernel(const std::shared_ptr<entry>& program, const std::string& name, cl_int* err) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = program->kernels.find(name);
+    if (it != program->kernels.end()) {
+        if (err) *err = CL_SUCCESS;
+        return it->second;
+    }
+    cl_int status;
+    cl::Kernel krnl(program->program, name.c_str(), &status);
+    if (err) *err = status;
+    if (status == CL_SUCCESS) program->kernels[name] = krnl;
+    return krnl;
+}
+
+void program_cache::evict(const cl::Device& device) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.erase(device());
+}
+
+void program_cache::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+}
+
+size_t program_cache::hits() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_hits;
+}
+
+size_t program_cache::misses() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_misses;
+}
+
+double program_cache::load_time_ms() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_load_time_ms;
+}
+
+void program_cache::print_stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    printf("Program cache: %zu hit(s), %zu miss(es), %.2f ms spent loading xclbins\n", m_hits, m_misses,
+           m_load_time_ms);
+}
+
+const char* page_backing_name(page_backing backing) {
+    switch (backing) {
+        case page_backing::huge_1g:
+            return "1 GiB huge pages";
+        case page_backing::huge_2m:
+            return "2 MiB huge pages";
+        case page_backing::transparent_huge:
+            return "transparent huge pages";
+        default:
+            return "4 KiB pages";
+    }
+}
+
+namespace {
+struct huge_alloc {
+    size_t length;
+    page_backing backing;
+};
+std::mutex huge_alloc_mutex;
+std::map<void*, huge_alloc> huge_allocs;
+
+size_t round_up(size_t bytes, size_t align) {
+    return (bytes + align - 1) / align * align;
+}
+
+#if !defined(_WINDOWS)
+void* map_anonymous(size_t length, int flags) {
+    void* ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+    return ptr == MAP_FAILED ? nullptr : ptr;
+}
+#endif
+}
+
+void* alloc_huge_pages(size_t bytes, bool prefault, bool lock, page_backing* backing) {
+    const size_t page_4k = 4096;
+    const size_t page_2m = 2UL << 20;
+    void* ptr = nullptr;
+    huge_alloc info = {round_up(bytes ? bytes : 1, page_4k), page_backing::small_pages};
+
+#if defined(_WINDOWS)
+    ptr = _aligned_malloc(info.length, page_4k);
+#else
+    int populate = prefault ? MAP_POPULATE : 0;
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_1GB)
+    const size_t page_1g = 1UL << 30;
+    // Only worth 1 GiB pages if rounding up wastes at most 1/8 of the
+    // mapping, otherwise 2 MiB pages fit much tighter
+    if (ptr == nullptr && bytes >= page_1g && (round_up(bytes, page_1g) - bytes) * 8 <= round_up(bytes, page_1g)) {
+        ptr = map_anonymous(round_up(bytes, page_1g), MAP_HUGETLB | MAP_HUGE_1GB | populate);
+        if (ptr) info = {round_up(bytes, page_1g), page_backing::huge_1g};
+    }
+#endif
+#if defined(MAP_HUGETLB)
+    if (ptr == nullptr && bytes >= page_2m) {
+        int flags = MAP_HUGETLB | populate;
+#if defined(MAP_HUGE_2MB)
+        flags |= MAP_HUGE_2MB;
+#endif
+        ptr = map_anonymous(round_up(bytes, page_2m), flags);
+        if (ptr) info = {round_up(bytes, page_2m), page_backing::huge_2m};
+    }
+#endif
+#if defined(MADV_HUGEPAGE)
+    if (ptr == nullptr && bytes >= page_2m) {
+        // No hugetlbfs pool: over-allocate, trim to a 2 MiB aligned range and
+        // let khugepaged/the fault handler back it with transparent huge pages.
+        size_t length = round_up(bytes, page_2m);
+        char* raw = reinterpret_cast<char*>(map_anonymous(length + page_2m, 0));
+        if (raw) {
+            char* aligned = reinterpret_cast<char*>(round_up(reinterpret_cast<uintptr_t>(raw), page_2m));
+            if (aligned != raw) munmap(raw, aligned - raw);
+            munmap(aligned + length, (raw + page_2m) - aligned);
+            if (madvise(aligned, length, MADV_HUGEPAGE) == 0) {
+                info = {length, page_backing::transparent_huge};
+            } else {
+                info = {length, page_backing::small_pages};
+            }
+            ptr = aligned;
+            if (prefault) {
+                // MAP_POPULATE would have faulted before madvise() took effect
+                for (size_t off = 0; off < length; off += page_4k) aligned[off] = 0;
+            }
+        }
+    }
+#endif
+    if (ptr == nullptr) {
+        ptr = map_anonymous(info.length, populate);
+        info.backing = page_backing::small_pages;
+    }
+    if (ptr && lock && mlock(ptr, info.length) != 0) {
+        std::cout << "WARNING: Unable to lock " << convert_size(info.length)
+                  << " of host memory, check ulimit -l" << std::endl;
+    }
+#endif
+    if (ptr == nullptr) return nullptr;
+
+    std::lock_guard<std::mutex> guard(huge_alloc_mutex);
+    huge_allocs[ptr] = info;
+    if (backing) *backing = info.backing;
+    return ptr;
+}
+
+void free_huge_pages(void* ptr) {
+    if (ptr == nullptr) return;
+    huge_alloc info;
+    {
+        std::lock_guard<std::mutex> guard(huge_alloc_mutex);
+        auto it = huge_allocs.find(ptr);
+        if (it == huge_allocs.end()) return;
+        info = it->second;
+        huge_allocs.erase(it);
+    }
+#if defined(_WINDOWS)
+    _aligned_free(ptr);
+#else
+    munmap(ptr, info.length);
+#endif
+}
+
+page_backing get_page_backing(const void* ptr) {
+    std::lock_guard<std::mutex> guard(huge_alloc_mutex);
+    auto it = huge_allocs.find(const_cast<void*>(ptr));
+    return it == huge_allocs.end() ? page_backing::small_pages : it->second.backing;
+}
+
+buffer_pool::buffer_pool(const cl::Context& context, size_t max_bytes)
+    : m_context(context), m_max_bytes(max_bytes), m_allocations(0), m_reuses(0), m_bytes(0) {}
+
+cl::Buffer buffer_pool::acquire(size_t size, cl_mem_flags flags, int bank, bool* fresh, cl_int* err) {
+    if (flags & CL_MEM_USE_HOST_PTR) {
+        if (err) *err = CL_INVALID_VALUE;
+        return cl::Buffer();
+    }
+    key k = {size, flags, bank};
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_free.find(k);
+    if (it != m_free.end() && !it->second.empty()) {
+        cl::Buffer buffer = it->second.back();
+        it->second.pop_back();
+        m_in_use[buffer()] = k;
+        m_reuses++;
+        if (fresh) *fresh = false;
+        if (err) *err = CL_SUCCESS;
+        return buffer;
+    }
+
+    trim(size);
+    cl_int status;
+    cl::Buffer buffer;
+    if (bank >= 0) {
+        cl_mem_ext_ptr_t ext;
+        ext.flags = bank | XCL_MEM_TOPOLOGY;
+        ext.obj = nullptr;
+        ext.param = 0;
+        buffer = cl::Buffer(m_context, flags | CL_MEM_EXT_PTR_XILINX, size, &ext, &status);
+    } else {
+        buffer = cl::Buffer(m_context, flags, size, nullptr, &status);
+    }
+    if (err) *err = status;
+    if (fresh) *fresh = true;
+    if (status != CL_SUCCESS) return cl::Buffer();
+    m_in_use[buffer()] = k;
+    m_allocations++;
+    m_bytes += size;
+    return buffer;
+}
+
+void buffer_pool::release(const cl::Buffer& buffer) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_in_use.find(buffer());
+    if (it == m_in_use.end()) return;
+    m_free[it->second].push_back(buffer);
+    m_in_use.erase(it);
+}
+
+void buffer_pool::trim(size_t needed) {
+    if (m_max_bytes == 0) return;
+    // Release the largest free buffers first, they are the least likely to
+    // be asked for again in a size sweep.
+    auto it = m_free.end();
+    while (m_bytes + needed > m_max_bytes && it != m_free.begin()) {
+        --it;
+        while (!it->second.empty() && m_bytes + needed > m_max_bytes) {
+            it->second.pop_back();
+            m_bytes -= it->first.size;
+        }
+    }
+}
+
+void buffer_pool::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& entry : m_free) m_bytes -= entry.first.size * entry.second.size();
+    m_free.clear();
+}
+
+void buffer_pool::print_stats(const char* name) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    printf("%s: %zu allocation(s), %zu reuse(s), %s held\n", name, m_allocations, m_reuses,
+           convert_size(m_bytes).c_str());
+}
+
+device_group::device_group(const std::vector<cl::Device>& devices,
+                           const std::vector<std::string>& xclbins,
+                           const std::vector<std::string>& kernel_names,
+                           cl_command_queue_properties queue_properties,
+                           size_t max_threads)
+    : m_members(devices.size()), m_read_time_ms(0), m_total_time_ms(0) {
+    if (xclbins.size() != devices.size()) {
+        std::cout << "ERROR: device_group needs one xclbin per device" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // Devices loading the same file share a single mapping of it
+    std::map<std::string, std::unique_ptr<binary_file> > files;
+    for (auto& name : xclbins) {
+        if (files.find(name) == files.end()) files[name].reset(new binary_file(name));
+    }
+    m_read_time_ms =
+        std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    for (size_t d = 0; d < devices.size(); d++) {
+        m_members[d].device = devices[d];
+        m_members[d].xclbin = xclbins[d];
+        m_members[d].err = CL_SUCCESS;
+        m_members[d].context_time_ms = 0;
+        m_members[d].program_time_ms = 0;
+    }
+
+    size_t threads = max_threads ? std::min(max_threads, devices.size()) : devices.size();
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; t++) {
+        workers.emplace_back([&] {
+            for (size_t d = next++; d < m_members.size(); d = next++) {
+                member& m = m_members[d];
+                init_member(m, *files.find(m.xclbin)->second, kernel_names, queue_properties);
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    m_total_time_ms =
+        std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void device_group::init_member(member& m,
+                               const binary_file& xclbin,
+                               const std::vector<std::string>& kernel_names,
+                               cl_command_queue_properties queue_properties) {
+    auto start = std::chrono::high_resolution_clock::now();
+    m.name = m.device.getInfo<CL_DEVICE_NAME>(&m.err);
+    if (m.err == CL_SUCCESS) m.context = cl::Context(m.device, nullptr, nullptr, nullptr, &m.err);
+    if (m.err == CL_SUCCESS) m.queue = cl::CommandQueue(m.context, m.device, queue_properties, &m.err);
+    auto created = std::chrono::high_resolution_clock::now();
+    m.context_time_ms = std::chrono::duration<double, std::milli>(created - start).count();
+    if (m.err != CL_SUCCESS) return;
+
+    m.program = cl::Program(m.context, {m.device}, xclbin.binaries(), nullptr, &m.err);
+    for (size_t k = 0; k < kernel_names.size() && m.err == CL_SUCCESS; k++) {
+        m.kernels.push_back(cl::Kernel(m.program, kernel_names[k].c_str(), &m.err));
+    }
+    m.program_time_ms =
+        std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - created).count();
+}
+
+bool device_group::ok() const {
+    for (auto& m : m_members) {
+        if (m.err != CL_SUCCESS) return false;
+    }
+    return true;
+}
+
+void device_group::print_stats() const {
+    double serial_ms = m_read_time_ms;
+    for (size_t d = 0; d < m_members.size(); d++) {
+        const member& m = m_members[d];
+        serial_ms += m.context_time_ms + m.program_time_ms;
+        if (m.err != CL_SUCCESS) {
+            printf("Device[%zu] %s: failed to load %s (error %d)\n", d, m.name.c_str(), m.xclbin.c_str(), m.err);
+        } else {
+            printf("Device[%zu] %s: context %.1f ms, program %.1f ms\n", d, m.name.c_str(), m.context_time_ms,
+                   m.program_time_ms);
+        }
+    }
+    printf("Device group: %zu device(s) ready in %.1f ms, xclbin reads %.1f ms, %.1f ms if run serially\n",
+           m_members.size(), m_total_time_ms, m_read_time_ms, serial_ms);
+}
+
 bool is_emulation() {
     bool ret = false;
     char* xcl_mode = getenv("XCL_EMULATION_MODE");
@@ -34,6 +34,9 @@
 #include <CL/cl_ext_xilinx.h>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
 // When creating a buffer with user pointer (CL_MEM_USE_HOST_PTR), under the
 // hood
 // User ptr is used if and only if it is properly aligned (page aligned). When
@@ -86,13 +89,315 @@ struct aligned_allocator {
     }
 };
 
+namespace xcl {
+// How a hugepage_allocator buffer is backed, best first
+enum class page_backing { huge_1g, huge_2m, transparent_huge, small_pages };
+const char* page_backing_name(page_backing backing);
+// Allocates bytes on the largest page size the system can provide, falling
+// back from hugetlbfs 1 GiB and 2 MiB pages to transparent huge pages and
+// finally to regular pages. 1 GiB pages are only used when rounding up to
+// them wastes at most 1/8 of the mapping. The memory is always page aligned.
+void* alloc_huge_pages(size_t bytes, bool prefault, bool lock, page_backing* backing = nullptr);
+void free_huge_pages(void* ptr);
+// Backing of a pointer returned by alloc_huge_pages()
+page_backing get_page_backing(const void* ptr);
+}
+
+// Sibling of aligned_allocator for the large CL_MEM_USE_HOST_PTR/host buffers
+// used by the bandwidth examples. Huge pages cut the number of TLB entries and
+// page faults needed to cover the buffer by up to 512x. With prefault the
+// pages are populated at allocation time so that first touch faults do not
+// land inside the first timed migration; lock additionally mlock()s them.
+template <typename T>
+struct hugepage_allocator {
+    using value_type = T;
+
+    hugepage_allocator(bool prefault = true, bool lock = false) : prefault(prefault), lock(lock) {}
+
+    template <typename U>
+    hugepage_allocator(const hugepage_allocator<U>& other) : prefault(other.prefault), lock(other.lock) {}
+
+    T* allocate(std::size_t num) {
+        void* ptr = xcl::alloc_huge_pages(num * sizeof(T), prefault, lock);
+        if (ptr == nullptr) throw std::bad_alloc();
+        return reinterpret_cast<T*>(ptr);
+    }
+    void deallocate(T* p, std::size_t num) { xcl::free_huge_pages(p); }
+
+    template <typename U>
+    bool operator==(const hugepage_allocator<U>& other) const {
+        return prefault == other.prefault && lock == other.lock;
+    }
+    template <typename U>
+    bool operator!=(const hugepage_allocator<U>& other) const {
+        return !(*this == other);
+    }
+
+    bool prefault;
+    bool lock;
+};
+
+namespace xcl {
+// NUMA node aware allocation: pages are bound to node with mbind(). A
+// negative node leaves placement to the default policy.
+void* alloc_on_node(size_t bytes, int node);
+void free_on_node(void* ptr, size_t bytes);
+}
+
+// Page aligned allocator whose pages live on a given NUMA node, typically
+// the node of the card the buffer is transferred to (see xcl::get_numa_node).
+template <typename T>
+struct numa_allocator {
+    using value_type = T;
+
+    numa_allocator(int node = -1) : node(node) {}
+
+    template <typename U>
+    numa_allocator(const numa_allocator<U>& other) : node(other.node) {}
+
+    T* allocate(std::size_t num) {
+        void* ptr = xcl::alloc_on_node(num * sizeof(T), node);
+        if (ptr == nullptr) throw std::bad_alloc();
+        return reinterpret_cast<T*>(ptr);
+    }
+    void deallocate(T* p, std::size_t num) { xcl::free_on_node(p, num * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const numa_allocator<U>& other) const {
+        return node == other.node;
+    }
+    template <typename U>
+    bool operator!=(const numa_allocator<U>& other) const {
+        return node != other.node;
+    }
+
+    int node;
+};
+
+struct axlf;
+
 namespace xcl {
 std::vector<cl::Device> get_xil_devices();
 std::vector<cl::Device> get_devices(const std::string& vendor_name);
 cl::Device find_device_bdf(const std::vector<cl::Device>& devices, const std::string& bdf);
 cl_device_id find_device_bdf_c(cl_device_id* devices, const std::string& bdf, cl_uint dev_count);
 std::string convert_size(size_t size);
+// Root of the sysfs tree the NUMA helpers read: $XCL_SYSFS_ROOT if set, so
+// that examples can be pointed at a fake tree for testing, /sys otherwise.
+std::string default_sysfs_root();
+// NUMA node of the PCIe function, read from <sysfs_root>/bus/pci/devices/<bdf>/numa_node.
+// Returns -1 when the platform does not report one.
+int get_numa_node(const std::string& bdf, const std::string& sysfs_root = default_sysfs_root());
+int get_numa_node(const cl::Device& device, const std::string& sysfs_root = default_sysfs_root());
+// CPUs of a node from <sysfs_root>/devices/system/node/node<N>/cpulist
+std::vector<int> get_node_cpus(int node, const std::string& sysfs_root = default_sysfs_root());
+// Parses a kernel cpulist string such as "0-11,24-35"
+std::vector<int> parse_cpu_list(const std::string& cpu_list);
+// Pins the calling thread to the CPUs of node, returns false if not possible
+bool bind_thread_to_node(int node, const std::string& sysfs_root = default_sysfs_root());
 std::vector<unsigned char> read_binary_file(const std::string& xclbin_file_name);
+
+// Read-only, memory mapped view of an xclbin file. Nothing is copied: the
+// pages are faulted in from the page cache only when they are touched, so
+// a caller that only asks for the UUID or for a metadata section such as
+// MEM_TOPOLOGY never reads the bitstream. The section table itself is parsed
+// on the first section lookup. The view can be passed directly to
+// cl::Program (binaries()) or to xrt::device::load_xclbin (top()) and must
+// outlive those calls.
+class binary_file {
+   public:
+    explicit binary_file(const std::string& xclbin_file_name);
+    ~binary_file();
+
+    binary_file(const binary_file&) = delete;
+    binary_file& operator=(const binary_file&) = delete;
+
+    const unsigned char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    const std::string& name() const { return m_name; }
+
+    // True if the file starts with the "xclbin2" magic
+    bool is_axlf() const;
+    const axlf* top() const { return reinterpret_cast<const axlf*>(m_data); }
+    cl::Program::Binaries binaries() const { return {{m_data, m_size}}; }
+
+    // xclbin UUID formatted like xrt::uuid::to_string(), empty if not an axlf
+    std::string uuid() const;
+
+    // Returns the payload of the first section of the given axlf_section_kind,
+    // or nullptr when the xclbin does not carry it.
+    const unsigned char* section(int kind, size_t* section_size = nullptr) const;
+
+   private:
+    void index_sections() const;
+
+    std::string m_name;
+    unsigned char* m_data;
+    size_t m_size;
+    mutable std::once_flag m_indexed;
+    mutable std::map<int, std::pair<uint64_t, uint64_t> > m_sections;
+};
+
+// Process wide cache of programmed devices. A device holds a single xclbin
+// at a time, so the cache keeps one entry per device tagged with the xclbin
+// UUID. Asking again for the image that is already on the device returns the
+// existing context, program and kernels without reprogramming it; asking for
+// a different image drops the old entry first. Kernels are shared between
+// callers, so callers that set arguments concurrently must serialize.
+// The cache is a static object; call clear() before main returns so the
+// cached OpenCL objects are released while the runtime is still up, not
+// during static destruction.
+class program_cache {
+   public:
+    struct entry {
+        std::string uuid;
+        cl::Device device;
+        cl::Context context;
+        cl::Program program;
+        std::map<std::string, cl::Kernel> kernels;
+    };
+
+    static program_cache& instance();
+
+    // Returns nullptr and sets err when the device rejects the xclbin
+    std::shared_ptr<entry> get(const cl::Device& device, const binary_file& xclbin, cl_int* err = nullptr);
+    cl::Kernel get_kernel(const std::shared_ptr<entry>& program, const std::string& name, cl_int* err = nullptr);
+
+    // Forget the image cached for the device, e.g. before loading it from
+    // outside of the cache.
+    void evict(const cl::Device& device);
+    // Forget every image; required before main returns
+    void clear();
+
+    size_t hits() const;
+    size_t misses() const;
+    // Total time spent in cl::Program creation on misses
+    double load_time_ms() const;
+    void print_stats() const;
+
+   private:
+    program_cache() : m_hits(0), m_misses(0), m_load_time_ms(0) {}
+
+    mutable std::mutex m_mutex;
+    std::map<cl_device_id, std::shared_ptr<entry> > m_entries;
+    size_t m_hits;
+    size_t m_misses;
+    double m_load_time_ms;
+};
+
+// Recycles cl::Buffer objects instead of creating and releasing a device
+// allocation for every use. Free buffers are kept per (size, flags, bank)
+// key; sizes are matched exactly because migrations always move the whole
+// buffer. Buffers that have never been handed out before are reported
+// through "fresh" so that callers only initialize them once. When max_bytes
+// is set, free buffers of other keys are released to stay under it.
+class buffer_pool {
+   public:
+    explicit buffer_pool(const cl::Context& context, size_t max_bytes = 0);
+
+    // bank is a MEM_TOPOLOGY index, or -1 to let the runtime place the buffer.
+    // CL_MEM_USE_HOST_PTR buffers cannot be pooled.
+    cl::Buffer acquire(size_t size,
+                       cl_mem_flags flags = CL_MEM_READ_WRITE,
+                       int bank = -1,
+                       bool* fresh = nullptr,
+                       cl_int* err = nullptr);
+    void release(const cl::Buffer& buffer);
+    template <typename C>
+    void release_all(const C& buffers) {
+        for (auto& buffer : buffers) release(static_cast<const cl::Buffer&>(buffer));
+    }
+    // Releases every free buffer back to the runtime
+    void clear();
+
+    size_t allocations() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_allocations;
+    }
+    size_t reuses() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_reuses;
+    }
+    // Device memory currently held by the pool, in use or free
+    size_t bytes_held() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_bytes;
+    }
+    void print_stats(const char* name = "Buffer pool") const;
+
+   private:
+    struct key {
+        size_t size;
+        cl_mem_flags flags;
+        int bank;
+        bool operator<(const key& other) const {
+            if (size != other.size) return size < other.size;
+            if (flags != other.flags) return flags < other.flags;
+            return bank < other.bank;
+        }
+    };
+    void trim(size_t needed);
+
+    cl::Context m_context;
+    size_t m_max_bytes;
+    mutable std::mutex m_mutex;
+    std::map<key, std::vector<cl::Buffer> > m_free;
+    std::map<cl_mem, key> m_in_use;
+    size_t m_allocations;
+    size_t m_reuses;
+    size_t m_bytes;
+};
+
+// Opens and programs a set of devices concurrently. Each distinct xclbin path
+// is mapped once and shared by every device that loads it, and a pool of
+// worker threads creates the context, queue, program and kernels of each
+// device, so startup time follows the slowest device instead of the sum of
+// all of them. Per-device timing is kept for reporting.
+class device_group {
+   public:
+    struct member {
+        cl::Device device;
+        std::string name;
+        std::string xclbin;
+        cl::Context context;
+        cl::CommandQueue queue;
+        cl::Program program;
+        // One kernel per requested name, in the same order
+        std::vector<cl::Kernel> kernels;
+        cl_int err;
+        double context_time_ms;
+        double program_time_ms;
+    };
+
+    // xclbins[d] is loaded on devices[d]. max_threads of 0 uses one thread
+    // per device.
+    device_group(const std::vector<cl::Device>& devices,
+                 const std::vector<std::string>& xclbins,
+                 const std::vector<std::string>& kernel_names,
+                 cl_command_queue_properties queue_properties = 0,
+                 size_t max_threads = 0);
+
+    size_t size() const { return m_members.size(); }
+    member& operator[](size_t index) { return m_members[index]; }
+    const member& operator[](size_t index) const { return m_members[index]; }
+    // True when every device was programmed and every kernel was created
+    bool ok() const;
+
+    double read_time_ms() const { return m_read_time_ms; }
+    // Wall clock time of the whole initialization, including the reads
+    double total_time_ms() const { return m_total_time_ms; }
+    void print_stats() const;
+
+   private:
+    void init_member(member& m,
+                     const binary_file& xclbin,
+                     const std::vector<std::string>& kernel_names,
+                     cl_command_queue_properties queue_properties);
+
+    std::vector<member> m_members;
+    double m_read_time_ms;
+    double m_total_time_ms;
+};
 bool is_emulation();
 bool is_hw_emulation();
 bool is_xpr_device(const char* device_name);
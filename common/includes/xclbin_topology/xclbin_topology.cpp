@@ -0,0 +1,213 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+#include "xclbin_topology.h"
+#include "xclbin.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+namespace xcl {
+
+namespace {
+
+std::string fixed_string(const void* src, size_t max_len) {
+    const char* str = static_cast<const char*>(src);
+    return std::string(str, strnlen(str, max_len));
+}
+
+bool is_streaming(int type) {
+    return type == MEM_STREAMING || type == MEM_STREAMING_CONNECTION;
+}
+
+} // namespace
+
+xclbin_topology::xclbin_topology(const std::string& xclbin_file_name) : m_name(xclbin_file_name) {
+    std::ifstream file(xclbin_file_name.c_str(), std::ifstream::binary);
+    if (!file) {
+        printf("ERROR: %s xclbin not available please build\n", xclbin_file_name.c_str());
+        exit(EXIT_FAILURE);
+    }
+    file.seekg(0, file.end);
+    uint64_t file_size = file.tellg();
+
+    load(
+        [&file](uint64_t offset, size_t size, void* dst) {
+            file.clear();
+            file.seekg(offset, file.beg);
+            return static_cast<bool>(file.read(static_cast<char*>(dst), size));
+        },
+        file_size);
+}
+
+xclbin_topology::xclbin_topology(const void* data, size_t size, const std::string& name) : m_name(name) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    load(
+        [bytes, size](uint64_t offset, size_t len, void* dst) {
+            if (offset > size || len > size - offset) return false;
+            memcpy(dst, bytes + offset, len);
+            return true;
+        },
+        size);
+}
+
+void xclbin_topology::load(const reader& read, uint64_t file_size) {
+    axlf top;
+    if (file_size < sizeof(axlf) || !read(0, sizeof(axlf), &top) || memcmp(top.m_magic, "xclbin2", 7) != 0) {
+        printf("ERROR: %s is not an xclbin2 file\n", m_name.c_str());
+        exit(EXIT_FAILURE);
+    }
+
+    // The count comes from the file, bound it by the file size before
+    // allocating the table
+    uint32_t count = top.m_header.m_numSections;
+    if (count > (file_size - offsetof(axlf, m_sections)) / sizeof(axlf_section_header)) {
+        printf("ERROR: %s has a truncated section table\n", m_name.c_str());
+        exit(EXIT_FAILURE);
+    }
+    std::vector<axlf_section_header> headers(count);
+    if (count && !read(offsetof(axlf, m_sections), count * sizeof(axlf_section_header), headers.data())) {
+        printf("ERROR: %s has a truncated section table\n", m_name.c_str());
+        exit(EXIT_FAILURE);
+    }
+
+    // Payload of the first section of a kind, matching xclbin::get_axlf_section()
+    auto load_section = [&](int kind, std::vector<unsigned char>& payload) {
+        for (auto& hdr : headers) {
+            if (static_cast<int>(hdr.m_sectionKind) != kind) continue;
+            if (hdr.m_sectionOffset > file_size || hdr.m_sectionSize > file_size - hdr.m_sectionOffset) {
+                printf("ERROR: %s has a truncated section %d\n", m_name.c_str(), kind);
+                exit(EXIT_FAILURE);
+            }
+            payload.resize(hdr.m_sectionSize);
+            if (!read(hdr.m_sectionOffset, hdr.m_sectionSize, payload.data())) {
+                printf("ERROR: %s has a truncated section %d\n", m_name.c_str(), kind);
+                exit(EXIT_FAILURE);
+            }
+            return;
+        }
+        payload.clear();
+    };
+    // Every section starts with an int32 count followed by the entries
+    auto entries = [&](const std::vector<unsigned char>& payload, size_t first, size_t entry_size) {
+        if (payload.size() < sizeof(int32_t)) return 0;
+        int32_t n;
+        memcpy(&n, payload.data(), sizeof(n));
+        if (n < 0 || first + n * entry_size > payload.size()) {
+            printf("ERROR: %s has a malformed metadata section\n", m_name.c_str());
+            exit(EXIT_FAILURE);
+        }
+        return static_cast<int>(n);
+    };
+
+    std::vector<unsigned char> topology, connections, layout;
+    load_section(MEM_TOPOLOGY, topology);
+    load_section(CONNECTIVITY, connections);
+    load_section(IP_LAYOUT, layout);
+
+    int num_banks = entries(topology, offsetof(mem_topology, m_mem_data), sizeof(mem_data));
+    for (int i = 0; i < num_banks; i++) {
+        mem_data mem;
+        memcpy(&mem, topology.data() + offsetof(mem_topology, m_mem_data) + i * sizeof(mem_data), sizeof(mem));
+        bank b;
+        b.index = i;
+        b.tag = fixed_string(mem.m_tag, sizeof(mem.m_tag));
+        b.type = mem.m_type;
+        b.used = mem.m_used != 0;
+        b.base_address = mem.m_base_address;
+        b.size_kb = mem.m_size;
+        m_banks.push_back(b);
+    }
+
+    // Only kernel IPs are compute units; remember where each one landed
+    int num_ips = entries(layout, offsetof(ip_layout, m_ip_data), sizeof(ip_data));
+    std::vector<int> cu_of_ip(num_ips, -1);
+    for (int i = 0; i < num_ips; i++) {
+        ip_data ip;
+        memcpy(&ip, layout.data() + offsetof(ip_layout, m_ip_data) + i * sizeof(ip_data), sizeof(ip));
+        if (ip.m_type != IP_KERNEL) continue;
+        std::string full_name = fixed_string(ip.m_name, sizeof(ip.m_name));
+        size_t colon = full_name.find(':');
+        compute_unit cu;
+        cu.kernel = full_name.substr(0, colon);
+        cu.name = colon == std::string::npos ? full_name : full_name.substr(colon + 1);
+        cu.base_address = ip.m_base_address;
+        cu_of_ip[i] = m_cus.size();
+        m_cus.push_back(cu);
+    }
+
+    int num_connections = entries(connections, offsetof(connectivity, m_connection), sizeof(connection));
+    for (int i = 0; i < num_connections; i++) {
+        connection conn;
+        memcpy(&conn, connections.data() + offsetof(connectivity, m_connection) + i * sizeof(connection),
+               sizeof(conn));
+        if (conn.m_ip_layout_index < 0 || conn.m_ip_layout_index >= num_ips) continue;
+        if (conn.mem_data_index < 0 || conn.mem_data_index >= num_banks) continue;
+        int cu = cu_of_ip[conn.m_ip_layout_index];
+        if (cu < 0 || is_streaming(m_banks[conn.mem_data_index].type)) continue;
+        m_cus[cu].arg_banks[conn.arg_index].push_back(conn.mem_data_index);
+    }
+    for (auto& cu : m_cus) {
+        for (auto& arg : cu.arg_banks) {
+            std::sort(arg.second.begin(), arg.second.end());
+            arg.second.erase(std::unique(arg.second.begin(), arg.second.end()), arg.second.end());
+        }
+    }
+}
+
+const xclbin_topology::compute_unit* xclbin_topology::find_cu(const std::string& cu_name) const {
+    for (auto& cu : m_cus) {
+        if (cu.name == cu_name || cu.kernel + ":" + cu.name == cu_name) return &cu;
+    }
+    return nullptr;
+}
+
+std::vector<int> xclbin_topology::arg_banks(const std::string& cu_name, int arg) const {
+    auto cu = find_cu(cu_name);
+    if (cu == nullptr) return std::vector<int>();
+    auto it = cu->arg_banks.find(arg);
+    if (it == cu->arg_banks.end()) return std::vector<int>();
+    return it->second;
+}
+
+std::vector<int> xclbin_topology::spread(const std::vector<std::pair<std::string, int> >& args) const {
+    std::vector<int> picks;
+    std::vector<int> load(m_banks.size(), 0);
+    for (auto& arg : args) {
+        int pick = -1;
+        for (int b : arg_banks(arg.first, arg.second)) {
+            if (pick < 0 || load[b] < load[pick]) pick = b;
+        }
+        if (pick >= 0) load[pick]++;
+        picks.push_back(pick);
+    }
+    return picks;
+}
+
+void xclbin_topology::print() const {
+    printf("%s: %zu memory bank(s), %zu compute unit(s)\n", m_name.c_str(), m_banks.size(), m_cus.size());
+    for (auto& cu : m_cus) {
+        for (auto& arg : cu.arg_banks) {
+            printf("  %s:%s arg %d ->", cu.kernel.c_str(), cu.name.c_str(), arg.first);
+            for (int b : arg.second) printf(" %s", m_banks[b].tag.c_str());
+            printf("\n");
+        }
+    }
+}
+
+} // namespace xcl
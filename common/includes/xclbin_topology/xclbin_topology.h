@@ -0,0 +1,93 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+#ifndef XCLBIN_TOPOLOGY_H_
+#define XCLBIN_TOPOLOGY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace xcl {
+
+/*!
+ * Synopsis:
+ * 1.Reads the MEM_TOPOLOGY, CONNECTIVITY and IP_LAYOUT sections of an xclbin
+ *      straight from the file or from a buffer, without opening a device.
+ * 2.Builds a compute unit -> kernel argument -> memory bank map.
+ * 3.Spreads a list of kernel arguments across the banks they can reach, so
+ *      hosts do not need to hard-code bank indices.
+ *
+ * Bank numbers are MEM_TOPOLOGY indices, i.e. the value to pass as the
+ * memory group of an xrt::bo or to OR with XCL_MEM_TOPOLOGY in a
+ * cl_mem_ext_ptr_t.
+ */
+class xclbin_topology {
+   public:
+    struct bank {
+        int index;
+        std::string tag; // e.g. "HBM[3]", "DDR[0]"
+        int type;        // MEM_TYPE
+        bool used;
+        uint64_t base_address;
+        uint64_t size_kb;
+    };
+
+    struct compute_unit {
+        std::string kernel; // e.g. "krnl_vadd"
+        std::string name;   // e.g. "krnl_vadd_1"
+        uint64_t base_address;
+        std::map<int, std::vector<int> > arg_banks; // argument index -> bank indices
+    };
+
+    // Only the header, the section table and the three metadata sections are
+    // read from the file; the bitstream is skipped.
+    explicit xclbin_topology(const std::string& xclbin_file_name);
+    xclbin_topology(const void* data, size_t size, const std::string& name = "xclbin");
+
+    const std::vector<bank>& banks() const { return m_banks; }
+    const std::vector<compute_unit>& compute_units() const { return m_cus; }
+
+    // Accepts either the instance name ("krnl_vadd_1") or "kernel:instance"
+    const compute_unit* find_cu(const std::string& cu_name) const;
+
+    // Banks an argument is connected to, empty if the argument is not
+    // connected to memory (scalars, streams) or the CU does not exist.
+    std::vector<int> arg_banks(const std::string& cu_name, int arg) const;
+
+    // Picks one bank for each (CU, argument) pair, in order. Each argument
+    // gets the reachable bank that has been picked the fewest times so far,
+    // so arguments sharing a set of banks end up on different banks. An
+    // argument with no memory connection gets -1.
+    std::vector<int> spread(const std::vector<std::pair<std::string, int> >& args) const;
+
+    void print() const;
+
+   private:
+    typedef std::function<bool(uint64_t offset, size_t size, void* dst)> reader;
+    void load(const reader& read, uint64_t file_size);
+
+    std::string m_name;
+    std::vector<bank> m_banks;
+    std::vector<compute_unit> m_cus;
+};
+
+} // namespace xcl
+
+#endif
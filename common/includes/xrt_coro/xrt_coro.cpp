@@ -0,0 +1,173 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+
+#include "xrt_coro.h"
+
+namespace xcl {
+
+// How long the completion thread blocks on the oldest run before it checks
+// the other ones, which may have finished first on another compute unit
+static const std::chrono::milliseconds completion_poll(1);
+
+static bool finished(ert_cmd_state state) {
+    return state != ERT_CMD_STATE_NEW && state != ERT_CMD_STATE_QUEUED && state != ERT_CMD_STATE_RUNNING &&
+           state != ERT_CMD_STATE_SUBMITTED;
+}
+
+std::coroutine_handle<> task::promise_type::final_awaiter::await_suspend(
+    std::coroutine_handle<promise_type> h) noexcept {
+    promise_type& p = h.promise();
+    if (p.continuation) return p.continuation;
+    // A spawned task; the reactor destroys it once resume() has returned
+    if (p.reactor) p.reactor->m_finished.push_back(h);
+    return std::noop_coroutine();
+}
+
+completion_reactor::completion_reactor(unsigned transfer_queues) : m_stop(false), m_active(0), m_next_queue(0) {
+    if (transfer_queues == 0) transfer_queues = 1;
+    for (unsigned q = 0; q < transfer_queues; q++) m_queues.emplace_back(new xrt::queue());
+    m_completion_thread = std::thread(&completion_reactor::completion_loop, this);
+}
+
+completion_reactor::~completion_reactor() {
+    m_queues.clear();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_pending_cv.notify_all();
+    m_completion_thread.join();
+}
+
+void completion_reactor::post(std::coroutine_handle<> h) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_ready.push_back(h);
+    }
+    m_ready_cv.notify_one();
+}
+
+void completion_reactor::spawn(task t) {
+    std::coroutine_handle<task::promise_type> h = std::exchange(t.m_handle, nullptr);
+    h.promise().reactor = this;
+    m_active++;
+    post(h);
+}
+
+bool completion_reactor::run_one() {
+    if (m_active == 0) return false;
+    std::coroutine_handle<> h;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_ready_cv.wait(lock, [this] { return !m_ready.empty(); });
+        h = m_ready.front();
+        m_ready.pop_front();
+    }
+    h.resume();
+
+    std::exception_ptr error;
+    for (auto f : m_finished) {
+        if (!error) error = f.promise().error;
+        f.destroy();
+        m_active--;
+    }
+    m_finished.clear();
+    if (error) std::rethrow_exception(error);
+    return true;
+}
+
+void completion_reactor::run() {
+    while (run_one()) {
+    }
+}
+
+void completion_reactor::run_awaiter::await_suspend(std::coroutine_handle<> h) {
+    {
+        std::lock_guard<std::mutex> lock(m_reactor.m_mutex);
+        m_reactor.m_pending.push_back({m_run, h, this});
+    }
+    m_reactor.m_pending_cv.notify_one();
+}
+
+ert_cmd_state completion_reactor::run_awaiter::await_resume() {
+    if (m_error) std::rethrow_exception(m_error);
+    return m_state;
+}
+
+void completion_reactor::sync_awaiter::await_suspend(std::coroutine_handle<> h) {
+    xrt::queue& queue = *m_reactor.m_queues[m_reactor.m_next_queue];
+    m_reactor.m_next_queue = (m_reactor.m_next_queue + 1) % m_reactor.m_queues.size();
+    queue.enqueue([this, h] {
+        try {
+            if (m_size == 0)
+                m_bo.sync(m_dir);
+            else
+                m_bo.sync(m_dir, m_size, m_offset);
+        } catch (...) {
+            m_error = std::current_exception();
+        }
+        m_reactor.post(h);
+    });
+}
+
+void completion_reactor::sync_awaiter::await_resume() {
+    if (m_error) std::rethrow_exception(m_error);
+}
+
+void completion_reactor::completion_loop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_pending_cv.wait(lock, [this] { return m_stop || !m_pending.empty(); });
+        if (m_stop) return;
+
+        // Only this thread removes runs, so the oldest one stays valid
+        // while the lock is released
+        xrt::run oldest = m_pending.front().run;
+        lock.unlock();
+        try {
+            oldest.wait(completion_poll);
+        } catch (...) {
+            // Reported by state() below
+        }
+        lock.lock();
+
+        bool posted = false;
+        size_t kept = 0;
+        for (size_t i = 0; i < m_pending.size(); i++) {
+            pending_run& p = m_pending[i];
+            ert_cmd_state state;
+            std::exception_ptr error;
+            try {
+                state = p.run.state();
+            } catch (...) {
+                state = ERT_CMD_STATE_ERROR;
+                error = std::current_exception();
+            }
+            if (!finished(state)) {
+                m_pending[kept++] = p;
+                continue;
+            }
+            p.awaiter->m_state = state;
+            p.awaiter->m_error = error;
+            m_ready.push_back(p.handle);
+            posted = true;
+        }
+        m_pending.erase(m_pending.begin() + kept, m_pending.end());
+        if (posted) m_ready_cv.notify_one();
+    }
+}
+
+} // namespace xcl
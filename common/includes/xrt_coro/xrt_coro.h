@@ -0,0 +1,204 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+#ifndef XRT_CORO_H_
+#define XRT_CORO_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "experimental/xrt_bo.h"
+#include "experimental/xrt_kernel.h"
+#include "experimental/xrt_queue.h"
+
+namespace xcl {
+
+class completion_reactor;
+
+/*!
+ * A coroutine that returns nothing. It does not run until it is handed to
+ * completion_reactor::spawn() or awaited by another task. An exception it
+ * does not catch is rethrown where it is awaited, or by the reactor call
+ * that resumed a spawned task.
+ */
+class task {
+   public:
+    struct promise_type {
+        std::coroutine_handle<> continuation;
+        completion_reactor* reactor = nullptr; // set for spawned tasks
+        std::exception_ptr error;
+
+        task get_return_object() { return task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        struct final_awaiter {
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept;
+            void await_resume() noexcept {}
+        };
+        final_awaiter final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { error = std::current_exception(); }
+    };
+
+    task(task&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+    task(const task&) = delete;
+    task& operator=(const task&) = delete;
+    ~task() {
+        if (m_handle) m_handle.destroy();
+    }
+
+    // co_await child runs the child and resumes when it has finished
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        m_handle.promise().continuation = awaiting;
+        return m_handle;
+    }
+    void await_resume() {
+        if (m_handle.promise().error) std::rethrow_exception(m_handle.promise().error);
+    }
+
+   private:
+    friend class completion_reactor;
+    explicit task(std::coroutine_handle<promise_type> h) : m_handle(h) {}
+
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+/*!
+ * Synopsis:
+ * 1.Awaitable versions of run.wait() and bo.sync() for coroutines, so one
+ *      host thread can keep many runs and transfers in flight.
+ * 2.A completion thread blocks in the driver on the oldest outstanding run
+ *      and, each time it wakes up, collects every run that has finished.
+ * 3.bo.sync() blocks for the whole DMA, so syncs are carried out on a small
+ *      pool of xrt::queues instead.
+ * 4.Finished operations are queued for the host thread. Coroutines are only
+ *      ever resumed by run_one() and run(), on the thread that calls them,
+ *      so the coroutines themselves need no locking.
+ *
+ * Usage:
+ *      xcl::task request(xcl::completion_reactor& reactor, xrt::run& run, xrt::bo& bo) {
+ *          run.start();
+ *          co_await reactor.wait(run);
+ *          co_await reactor.sync(bo, XCL_BO_SYNC_BO_FROM_DEVICE);
+ *      }
+ *      reactor.spawn(request(reactor, run, bo));
+ *      reactor.run();
+ */
+class completion_reactor {
+   public:
+    explicit completion_reactor(unsigned transfer_queues = 4);
+    ~completion_reactor();
+
+    completion_reactor(const completion_reactor&) = delete;
+    completion_reactor& operator=(const completion_reactor&) = delete;
+
+    class run_awaiter {
+       public:
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h);
+        // State the run finished in, ERT_CMD_STATE_COMPLETED unless the
+        // kernel failed
+        ert_cmd_state await_resume();
+
+       private:
+        friend class completion_reactor;
+        run_awaiter(completion_reactor& reactor, const xrt::run& run) : m_reactor(reactor), m_run(run) {}
+
+        completion_reactor& m_reactor;
+        xrt::run m_run;
+        ert_cmd_state m_state = ERT_CMD_STATE_NEW;
+        std::exception_ptr m_error;
+    };
+
+    class sync_awaiter {
+       public:
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h);
+        void await_resume();
+
+       private:
+        friend class completion_reactor;
+        sync_awaiter(completion_reactor& reactor, const xrt::bo& bo, xclBOSyncDirection dir, size_t size, size_t offset)
+            : m_reactor(reactor), m_bo(bo), m_dir(dir), m_size(size), m_offset(offset) {}
+
+        completion_reactor& m_reactor;
+        xrt::bo m_bo;
+        xclBOSyncDirection m_dir;
+        size_t m_size;
+        size_t m_offset;
+        std::exception_ptr m_error;
+    };
+
+    // co_await wait(run) resumes once the run, already started, has finished
+    run_awaiter wait(const xrt::run& run) { return run_awaiter(*this, run); }
+    // co_await sync(bo, dir) resumes once the transfer is done; size 0
+    // syncs the whole buffer
+    sync_awaiter sync(const xrt::bo& bo, xclBOSyncDirection dir, size_t size = 0, size_t offset = 0) {
+        return sync_awaiter(*this, bo, dir, size, offset);
+    }
+
+    // Takes t over; it starts at the next run_one()
+    void spawn(task t);
+    // Spawned tasks that have not finished
+    size_t active() const { return m_active; }
+    // Waits for one finished operation and resumes its coroutine. Returns
+    // false at once when no task is active. Rethrows the exception of a
+    // spawned task that failed.
+    bool run_one();
+    // run_one() until every spawned task has finished
+    void run();
+
+   private:
+    friend struct task::promise_type::final_awaiter;
+
+    struct pending_run {
+        xrt::run run;
+        std::coroutine_handle<> handle;
+        run_awaiter* awaiter;
+    };
+
+    void post(std::coroutine_handle<> h);
+    void completion_loop();
+
+    std::mutex m_mutex;
+    std::condition_variable m_ready_cv;
+    std::condition_variable m_pending_cv;
+    std::deque<std::coroutine_handle<>> m_ready;
+    std::vector<pending_run> m_pending;
+    bool m_stop;
+
+    // Touched by the host thread only
+    size_t m_active;
+    std::vector<std::coroutine_handle<task::promise_type>> m_finished;
+    unsigned m_next_queue;
+
+    std::thread m_completion_thread;
+    // Last, so the queues are drained before anything above goes away
+    std::vector<std::unique_ptr<xrt::queue>> m_queues;
+};
+
+} // namespace xcl
+
+#endif
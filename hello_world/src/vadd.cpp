@@ -28,13 +28,11 @@ Description:
     The dataflow pragma instructs the compiler to enable task-level pipelining.
     This is required for to load/compute/store functions to execute in a parallel
     and pipelined manner.
-    The kernel operates on vectors of NUM_WORDS integers modeled using the hls::vector
-    data type. This datatype provides intuitive support for parallelism and
-    fits well the vector-add computation. The vector length is set to NUM_WORDS
-    since NUM_WORDS integers amount to a total of 64 bytes, which is the maximum size of
-    a kernel port. It is a good practice to match the compute bandwidth to the I/O
-    bandwidth. Here the kernel loads, computes and stores NUM_WORDS integer values per
-    clock cycle and is implemented as below:
+    The kernel loads, computes and stores one integer per clock cycle, which
+    uses 4 of the 64 bytes a kernel port can carry. It is a good practice to
+    match the compute bandwidth to the I/O bandwidth; performance/vadd_wide
+    shows the same kernel on hls::vector types that fill the port. The kernel
+    is implemented as below:
                                        _____________
                                       |             |<----- Input Vector 1 from Global Memory
                                       |  load_input |       __
@@ -0,0 +1,368 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+
+
+#include "bench.h"
+#include "cmdlineparser.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "xcl2.hpp"
+
+// XRT includes
+#include "experimental/xrt_bo.h"
+#include "experimental/xrt_device.h"
+#include "experimental/xrt_kernel.h"
+
+typedef std::chrono::steady_clock batch_clock;
+
+/*
+ * Coalesces many small vector additions into one vadd run.
+ *
+ * submit() queues a request and returns a future. A dispatcher thread takes
+ * up to max_requests queued requests, no more than capacity elements in
+ * total, and packs them back to back into one set of device buffers. The
+ * offset of each request in the batch is recorded next to it. One kernel run
+ * adds the whole batch, vadd being element-wise, and the dispatcher copies
+ * each request's slice of the output back to the caller and completes its
+ * future.
+ *
+ * A batch is launched as soon as it is full, or once its oldest request has
+ * waited max_wait. While a batch runs, new requests pile up in the queue, so
+ * even a max_wait of 0 coalesces under load.
+ */
+class vadd_batcher {
+   public:
+    struct stats {
+        size_t batches = 0;
+        size_t requests = 0;
+    };
+
+    vadd_batcher(const xrt::device& device,
+                 const xrt::kernel& krnl,
+                 size_t capacity,
+                 size_t max_requests,
+                 batch_clock::duration max_wait)
+        : m_capacity(capacity), m_max_requests(max_requests), m_max_wait(max_wait) {
+        m_in1 = xrt::bo(device, capacity * sizeof(int), krnl.group_id(0));
+        m_in2 = xrt::bo(device, capacity * sizeof(int), krnl.group_id(1));
+        m_out = xrt::bo(device, capacity * sizeof(int), krnl.group_id(2));
+        m_in1_map = m_in1.map<int*>();
+        m_in2_map = m_in2.map<int*>();
+        m_out_map = m_out.map<int*>();
+        m_run = xrt::run(krnl);
+        m_run.set_arg(0, m_in1);
+        m_run.set_arg(1, m_in2);
+        m_run.set_arg(2, m_out);
+        m_dispatcher = std::thread(&vadd_batcher::dispatch, this);
+    }
+
+    // Runs the requests still queued, then stops the dispatcher
+    ~vadd_batcher() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_ready.notify_one();
+        m_dispatcher.join();
+    }
+
+    vadd_batcher(const vadd_batcher&) = delete;
+    vadd_batcher& operator=(const vadd_batcher&) = delete;
+
+    // out[i] = in1[i] + in2[i] for i < count. The arrays must stay valid
+    // until the future is ready; requests larger than the batch capacity
+    // fail with std::length_error.
+    std::future<void> submit(const int* in1, const int* in2, int* out, size_t count) {
+        request req;
+        req.in1 = in1;
+        req.in2 = in2;
+        req.out = out;
+        req.count = count;
+        req.queued = batch_clock::now();
+        std::future<void> done = req.done.get_future();
+        if (count > m_capacity) {
+            req.done.set_exception(std::make_exception_ptr(std::length_error("request larger than a batch")));
+            return done;
+        }
+
+        bool wake;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queue.push_back(std::move(req));
+            m_queued_elements += count;
+            // The dispatcher only needs to know about the first request and
+            // about the one that fills a batch
+            wake = m_queue.size() == 1 || batch_full();
+        }
+        if (wake) m_ready.notify_one();
+        return done;
+    }
+
+    stats statistics() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stats;
+    }
+
+   private:
+    struct request {
+        const int* in1;
+        const int* in2;
+        int* out;
+        size_t count;
+        size_t offset; // in the batch buffers
+        batch_clock::time_point queued;
+        std::promise<void> done;
+    };
+
+    bool batch_full() const { return m_queue.size() >= m_max_requests || m_queued_elements >= m_capacity; }
+
+    void dispatch() {
+        std::vector<request> batch;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;) {
+            m_ready.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+            if (m_queue.empty()) return;
+            m_ready.wait_until(lock, m_queue.front().queued + m_max_wait, [this] { return m_stop || batch_full(); });
+
+            size_t elements = 0;
+            while (!m_queue.empty() && batch.size() < m_max_requests &&
+                   elements + m_queue.front().count <= m_capacity) {
+                batch.push_back(std::move(m_queue.front()));
+                m_queue.pop_front();
+                batch.back().offset = elements;
+                elements += batch.back().count;
+            }
+            m_queued_elements -= elements;
+            m_stats.batches++;
+            m_stats.requests += batch.size();
+
+            lock.unlock();
+            run_batch(batch, elements);
+            batch.clear();
+            lock.lock();
+        }
+    }
+
+    void run_batch(std::vector<request>& batch, size_t elements) {
+        for (auto& req : batch) {
+            memcpy(m_in1_map + req.offset, req.in1, req.count * sizeof(int));
+            memcpy(m_in2_map + req.offset, req.in2, req.count * sizeof(int));
+        }
+        m_in1.sync(XCL_BO_SYNC_BO_TO_DEVICE, elements * sizeof(int), 0);
+        m_in2.sync(XCL_BO_SYNC_BO_TO_DEVICE, elements * sizeof(int), 0);
+
+        m_run.set_arg(3, static_cast<int>(elements));
+        m_run.start();
+        m_run.wait();
+
+        m_out.sync(XCL_BO_SYNC_BO_FROM_DEVICE, elements * sizeof(int), 0);
+        for (auto& req : batch) {
+            memcpy(req.out, m_out_map + req.offset, req.count * sizeof(int));
+            req.done.set_value();
+        }
+    }
+
+    const size_t m_capacity; // elements per batch
+    const size_t m_max_requests;
+    const batch_clock::duration m_max_wait;
+
+    xrt::bo m_in1, m_in2, m_out;
+    int *m_in1_map, *m_in2_map, *m_out_map;
+    xrt::run m_run;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_ready;
+    std::deque<request> m_queue;
+    size_t m_queued_elements = 0;
+    bool m_stop = false;
+    stats m_stats;
+    std::thread m_dispatcher;
+};
+
+// One client's jobs, each waited for before the next one is sent
+struct client_jobs {
+    std::vector<int> in1, in2, out;
+    std::vector<double> latency; // seconds, one per job
+    size_t mismatches = 0;
+};
+
+static void check_job(client_jobs& jobs, size_t offset, size_t count) {
+    for (size_t i = offset; i < offset + count; i++) jobs.mismatches += jobs.out[i] != jobs.in1[i] + jobs.in2[i];
+}
+
+int main(int argc, char** argv) {
+    // Command Line Parser
+    sda::utils::CmdLineParser parser;
+
+    // Switches
+    //**************//"<Full Arg>",  "<Short Arg>", "<Description>", "<Default>"
+    parser.addSwitch("--xclbin_file", "-x", "input binary file string", "");
+    parser.addSwitch("--device_id", "-d", "device index", "0");
+    parser.addSwitch("--clients", "-c", "number of client threads", "16");
+    parser.addSwitch("--jobs", "-j", "jobs sent by each client", "1000");
+    parser.addSwitch("--job_size", "-s", "integers added by each job", "1024");
+    parser.addSwitch("--batch", "-b", "largest batch sizes to sweep, in requests", "1,4,16,64");
+    parser.addSwitch("--max_wait", "-w", "longest wait for a batch to fill to sweep, in microseconds", "0,100,1000");
+    parser.parse(argc, argv);
+
+    // Read settings
+    std::string binaryFile = parser.value("xclbin_file");
+    int device_index = stoi(parser.value("device_id"));
+
+    if (argc < 3) {
+        parser.printHelp();
+        return EXIT_FAILURE;
+    }
+
+    int num_clients = parser.value_to_int("clients");
+    int num_jobs = parser.value_to_int("jobs");
+    int job_size = parser.value_to_int("job_size");
+    std::vector<uint64_t> batch_sizes = parser.value_to_sweep("batch");
+    std::vector<uint64_t> max_waits = parser.value_to_sweep("max_wait");
+    if (num_clients < 1 || num_jobs < 1 || job_size < 1 || batch_sizes.empty() || max_waits.empty() ||
+        std::count(batch_sizes.begin(), batch_sizes.end(), 0)) {
+        parser.printHelp();
+        return EXIT_FAILURE;
+    }
+    if (xcl::is_emulation() && !parser.isValid("jobs")) {
+        num_jobs = 10;
+        std::cout << "Number of jobs is reduced for faster execution on emulation flow.\n";
+    }
+
+    std::cout << "Open the device" << device_index << std::endl;
+    auto device = xrt::device(device_index);
+    std::cout << "Load the xclbin " << binaryFile << std::endl;
+    auto uuid = device.load_xclbin(binaryFile);
+
+    auto krnl = xrt::kernel(device, uuid, "vadd");
+
+    std::vector<client_jobs> clients(num_clients);
+    for (int c = 0; c < num_clients; c++) {
+        auto& jobs = clients[c];
+        jobs.in1.resize((size_t)num_jobs * job_size);
+        jobs.in2.resize(jobs.in1.size());
+        jobs.out.resize(jobs.in1.size());
+        for (size_t i = 0; i < jobs.in1.size(); i++) {
+            jobs.in1[i] = c * 1000003 + i;
+            jobs.in2[i] = i * 7;
+        }
+    }
+
+    xcl::bench_options bench_opts;
+    bench_opts.warmup = 0;
+    bench_opts.repetitions = 1;
+    xcl::benchmark bench("batch_service_xrt", bench_opts.from_env());
+    double total_jobs = (double)num_clients * num_jobs;
+
+    // Runs client_body on one thread per client and reports the throughput
+    // and the latency percentiles of their jobs
+    bool match = true;
+    auto measure = [&](const std::string& mode, const std::string& batch, const std::string& wait,
+                       const std::function<void(int, client_jobs&)>& client_body,
+                       const std::function<double()>& avg_batch) {
+        for (auto& jobs : clients) {
+            jobs.latency.clear();
+            jobs.mismatches = 0;
+            std::fill(jobs.out.begin(), jobs.out.end(), 0);
+        }
+        std::string name = mode + ", batch " + batch + ", wait " + wait + " us";
+        xcl::bench_result result = bench.run(name,
+                                             [&] {
+                                                 std::vector<std::thread> threads;
+                                                 for (int c = 0; c < num_clients; c++)
+                                                     threads.emplace_back(client_body, c, std::ref(clients[c]));
+                                                 for (auto& t : threads) t.join();
+                                             },
+                                             total_jobs, "jobs/s");
+
+        std::vector<double> latency;
+        size_t mismatches = 0;
+        for (auto& jobs : clients) {
+            latency.insert(latency.end(), jobs.latency.begin(), jobs.latency.end());
+            mismatches += jobs.mismatches;
+        }
+        std::sort(latency.begin(), latency.end());
+        printf("%-10s %6s %9s %12.0f %10.1f %10.1f %10.1f\n", mode.c_str(), batch.c_str(), wait.c_str(), result.rate(),
+               avg_batch(), xcl::bench_percentile(latency, 0.5) * 1e6, xcl::bench_percentile(latency, 0.99) * 1e6);
+        if (mismatches) {
+            printf("%s: %zu results do not match\n", name.c_str(), mismatches);
+            match = false;
+        }
+    };
+
+    printf("%-10s %6s %9s %12s %10s %10s %10s\n", "Mode", "Batch", "Wait(us)", "jobs/s", "avg batch", "p50(us)",
+           "p99(us)");
+
+    // Baseline: every client launches vadd once per job with its own buffers
+    {
+        std::vector<xrt::bo> bos;
+        for (int c = 0; c < num_clients; c++) {
+            for (int arg = 0; arg < 3; arg++) bos.push_back(xrt::bo(device, job_size * sizeof(int), krnl.group_id(arg)));
+        }
+        measure("per-job", "1", "-", [&](int c, client_jobs& jobs) {
+            xrt::bo& in1 = bos[3 * c];
+            xrt::bo& in2 = bos[3 * c + 1];
+            xrt::bo& out = bos[3 * c + 2];
+            for (int j = 0; j < num_jobs; j++) {
+                size_t offset = (size_t)j * job_size;
+                auto start = batch_clock::now();
+                in1.write(&jobs.in1[offset]);
+                in2.write(&jobs.in2[offset]);
+                in1.sync(XCL_BO_SYNC_BO_TO_DEVICE);
+                in2.sync(XCL_BO_SYNC_BO_TO_DEVICE);
+                auto run = krnl(in1, in2, out, job_size);
+                run.wait();
+                out.sync(XCL_BO_SYNC_BO_FROM_DEVICE);
+                out.read(&jobs.out[offset]);
+                jobs.latency.push_back(std::chrono::duration<double>(batch_clock::now() - start).count());
+                check_job(jobs, offset, job_size);
+            }
+        }, [] { return 1.0; });
+    }
+
+    for (uint64_t batch : batch_sizes) {
+        for (uint64_t wait_us : max_waits) {
+            vadd_batcher batcher(device, krnl, batch * job_size, batch, std::chrono::microseconds(wait_us));
+            measure("batched", std::to_string(batch), std::to_string(wait_us), [&](int, client_jobs& jobs) {
+                for (int j = 0; j < num_jobs; j++) {
+                    size_t offset = (size_t)j * job_size;
+                    auto start = batch_clock::now();
+                    batcher.submit(&jobs.in1[offset], &jobs.in2[offset], &jobs.out[offset], job_size).get();
+                    jobs.latency.push_back(std::chrono::duration<double>(batch_clock::now() - start).count());
+                    check_job(jobs, offset, job_size);
+                }
+            }, [&] {
+                auto st = batcher.statistics();
+                return st.batches ? (double)st.requests / st.batches : 0;
+            });
+        }
+    }
+    bench.save();
+
+    std::cout << (match ? "TEST PASSED" : "TEST FAILED") << std::endl;
+    return match ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,241 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+
+
+#include "bench.h"
+#include "cmdlineparser.h"
+#include "fastmem.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+#include "xcl2.hpp"
+
+// XRT includes
+#include "experimental/xrt_bo.h"
+#include "experimental/xrt_device.h"
+#include "experimental/xrt_kernel.h"
+#include "experimental/xrt_queue.h"
+
+// One set of device buffers a chunk goes through, with the run that adds them
+struct bo_set {
+    xrt::bo in1, in2, out;
+    int *in1_map, *in2_map, *out_map;
+    xrt::run run;
+};
+
+// Time each stage spent busy over a whole input, in seconds
+struct stage_times {
+    double upload = 0, compute = 0, download = 0;
+
+    double busy() const { return upload + compute + download; }
+};
+
+template <typename F>
+static void timed(double& total, F body) {
+    auto start = std::chrono::high_resolution_clock::now();
+    body();
+    total += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// Each stage copies with a single thread, the other two stages run beside it
+static void upload_chunk(bo_set& set, const int* in1, const int* in2, size_t count) {
+    xcl::fast_copy(set.in1_map, in1, count * sizeof(int), 1);
+    xcl::fast_copy(set.in2_map, in2, count * sizeof(int), 1);
+    set.in1.sync(XCL_BO_SYNC_BO_TO_DEVICE, count * sizeof(int), 0);
+    set.in2.sync(XCL_BO_SYNC_BO_TO_DEVICE, count * sizeof(int), 0);
+}
+
+static void compute_chunk(bo_set& set, size_t count) {
+    set.run.set_arg(3, static_cast<int>(count));
+    set.run.start();
+    set.run.wait();
+}
+
+static void download_chunk(bo_set& set, int* out, size_t count) {
+    set.out.sync(XCL_BO_SYNC_BO_FROM_DEVICE, count * sizeof(int), 0);
+    xcl::fast_copy(out, set.out_map, count * sizeof(int), 1);
+}
+
+// Baseline: every chunk is uploaded, added and downloaded before the next one
+static void run_serialized(bo_set& set, const int* in1, const int* in2, int* out, size_t size, size_t chunk) {
+    for (size_t offset = 0; offset < size; offset += chunk) {
+        size_t count = std::min(chunk, size - offset);
+        upload_chunk(set, in1 + offset, in2 + offset, count);
+        compute_chunk(set, count);
+        download_chunk(set, out + offset, count);
+    }
+}
+
+/*
+ * Chunk k goes through BO set k % sets.size(), one queue per stage, so the
+ * upload of chunk k+1, the kernel run of chunk k and the download of chunk
+ * k-1 overlap. A set is reused for chunk k once chunk k - sets.size() no
+ * longer needs it: the upload waits for that chunk's kernel run to finish
+ * with the inputs, and the kernel run waits for its download to finish with
+ * the output.
+ */
+static stage_times run_pipelined(
+    std::vector<bo_set>& sets, const int* in1, const int* in2, int* out, size_t size, size_t chunk) {
+    stage_times t;
+    xrt::queue upload_queue;
+    xrt::queue compute_queue;
+    xrt::queue download_queue;
+    std::vector<xrt::queue::event> computed, downloaded;
+
+    for (size_t k = 0, offset = 0; offset < size; k++, offset += chunk) {
+        size_t count = std::min(chunk, size - offset);
+        bo_set* set = &sets[k % sets.size()];
+        bool reused = k >= sets.size();
+
+        if (reused) upload_queue.enqueue(computed[k - sets.size()]);
+        auto uploaded = upload_queue.enqueue(
+            [=, &t] { timed(t.upload, [&] { upload_chunk(*set, in1 + offset, in2 + offset, count); }); });
+
+        compute_queue.enqueue(uploaded);
+        if (reused) compute_queue.enqueue(downloaded[k - sets.size()]);
+        computed.push_back(compute_queue.enqueue([=, &t] { timed(t.compute, [&] { compute_chunk(*set, count); }); }));
+
+        download_queue.enqueue(computed.back());
+        downloaded.push_back(download_queue.enqueue(
+            [=, &t] { timed(t.download, [&] { download_chunk(*set, out + offset, count); }); }));
+    }
+    downloaded.back().wait();
+    return t;
+}
+
+static size_t count_mismatches(const int* in1, const int* in2, const int* out, size_t size) {
+    size_t mismatches = 0;
+    for (size_t i = 0; i < size; i++) mismatches += out[i] != in1[i] + in2[i];
+    return mismatches;
+}
+
+int main(int argc, char** argv) {
+    // Command Line Parser
+    sda::utils::CmdLineParser parser;
+
+    // Switches
+    //**************//"<Full Arg>",  "<Short Arg>", "<Description>", "<Default>"
+    parser.addSwitch("--xclbin_file", "-x", "input binary file string", "");
+    parser.addSwitch("--device_id", "-d", "device index", "0");
+    parser.addSwitch("--size", "-s", "size of each input vector, e.g. 64M", "64M");
+    parser.addSwitch("--chunk", "-c", "chunk sizes to sweep, e.g. 256K:16M:x4", "256K:16M:x4");
+    parser.addSwitch("--sets", "-n", "number of device buffer sets the chunks rotate through", "2");
+    parser.parse(argc, argv);
+
+    // Read settings
+    std::string binaryFile = parser.value("xclbin_file");
+    int device_index = stoi(parser.value("device_id"));
+
+    if (argc < 3) {
+        parser.printHelp();
+        return EXIT_FAILURE;
+    }
+
+    uint64_t size_bytes = parser.value_to_size("size");
+    std::vector<uint64_t> chunks = parser.value_to_sweep("chunk");
+    int num_sets = parser.value_to_int("sets");
+    if (xcl::is_emulation() && !parser.isValid("size") && !parser.isValid("chunk")) {
+        size_bytes = 64 * 1024;
+        chunks = {16 * 1024};
+        std::cout << "Vector and chunk sizes are reduced for faster execution on emulation flow.\n";
+    }
+    // Chunks hold at least one int, and no more than the kernel's int size argument
+    if (size_bytes < sizeof(int) || chunks.empty() || num_sets < 1 ||
+        *std::min_element(chunks.begin(), chunks.end()) < sizeof(int) ||
+        *std::max_element(chunks.begin(), chunks.end()) / sizeof(int) > INT32_MAX) {
+        parser.printHelp();
+        return EXIT_FAILURE;
+    }
+    size_t size = size_bytes / sizeof(int);
+    size_t max_chunk = std::min<uint64_t>(*std::max_element(chunks.begin(), chunks.end()), size * sizeof(int));
+
+    std::cout << "Open the device" << device_index << std::endl;
+    auto device = xrt::device(device_index);
+    std::cout << "Load the xclbin " << binaryFile << std::endl;
+    auto uuid = device.load_xclbin(binaryFile);
+
+    auto krnl = xrt::kernel(device, uuid, "vadd");
+
+    // The input lives in host memory and may be much larger than the device
+    // buffers, which only ever hold one chunk each
+    std::vector<int> in1(size), in2(size), out(size);
+    xcl::fast_fill_random(in1.data(), size, 1);
+    xcl::fast_fill_random(in2.data(), size, 2);
+
+    std::cout << "Allocate " << num_sets << " sets of 3 Buffers of " << max_chunk / 1024 << " KB in Global Memory\n";
+    std::vector<bo_set> sets(num_sets);
+    for (auto& set : sets) {
+        set.in1 = xrt::bo(device, max_chunk, krnl.group_id(0));
+        set.in2 = xrt::bo(device, max_chunk, krnl.group_id(1));
+        set.out = xrt::bo(device, max_chunk, krnl.group_id(2));
+        set.in1_map = set.in1.map<int*>();
+        set.in2_map = set.in2.map<int*>();
+        set.out_map = set.out.map<int*>();
+        set.run = xrt::run(krnl);
+        set.run.set_arg(0, set.in1);
+        set.run.set_arg(1, set.in2);
+        set.run.set_arg(2, set.out);
+    }
+
+    xcl::bench_options bench_opts;
+    if (xcl::is_emulation()) {
+        bench_opts.warmup = 0;
+        bench_opts.repetitions = 1;
+    }
+    xcl::benchmark bench("chunked_pipeline_xrt", bench_opts.from_env());
+
+    // Two inputs up and one output down per element
+    double gb = 3.0 * size * sizeof(int) / 1e9;
+    bool match = true;
+    printf("%10s %12s %12s %8s %14s\n", "Chunk", "serialized", "pipelined", "speedup", "overlap ratio");
+    for (uint64_t chunk_bytes : chunks) {
+        size_t chunk = std::min<size_t>(chunk_bytes / sizeof(int), size);
+        std::string name = std::to_string(chunk * sizeof(int) / 1024) + " KB chunks";
+        stage_times pipelined;
+
+        std::fill(out.begin(), out.end(), 0);
+        auto& base =
+            bench.run(name + ", serialized",
+                      [&] { run_serialized(sets[0], in1.data(), in2.data(), out.data(), size, chunk); }, gb, "GB/s");
+        size_t serial_mismatches = count_mismatches(in1.data(), in2.data(), out.data(), size);
+
+        std::fill(out.begin(), out.end(), 0);
+        auto& piped =
+            bench.run(name + ", " + std::to_string(num_sets) + " sets",
+                      [&] { pipelined = run_pipelined(sets, in1.data(), in2.data(), out.data(), size, chunk); }, gb,
+                      "GB/s");
+        size_t mismatches = count_mismatches(in1.data(), in2.data(), out.data(), size);
+        if (serial_mismatches || mismatches) {
+            printf("%s: %zu serialized and %zu pipelined results do not match\n", name.c_str(), serial_mismatches,
+                   mismatches);
+            match = false;
+        }
+
+        // Stage busy time over wall time of the last repetition: 1 when the
+        // stages ran one after another, up to 3 when all three always overlap
+        double wall = piped.seconds.back();
+        printf("%8zuKB %7.3f GB/s %7.3f GB/s %7.2fx %14.2f\n", chunk * sizeof(int) / 1024, base.rate(), piped.rate(),
+               piped.rate() / base.rate(), wall > 0 ? pipelined.busy() / wall : 0);
+        printf("%10s upload %.3f ms, compute %.3f ms, download %.3f ms busy in %.3f ms\n", "", pipelined.upload * 1e3,
+               pipelined.compute * 1e3, pipelined.download * 1e3, wall * 1e3);
+    }
+    bench.save();
+
+    std::cout << (match ? "TEST PASSED" : "TEST FAILED") << std::endl;
+    return match ? EXIT_SUCCESS : EXIT_FAILURE;
+}
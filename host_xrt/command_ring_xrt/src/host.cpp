@@ -0,0 +1,302 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+
+#include "bench.h"
+#include "cmdlineparser.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "vadd_ring.h"
+#include "xcl2.hpp"
+
+// XRT includes
+#include "experimental/xrt_bo.h"
+#include "experimental/xrt_device.h"
+#include "experimental/xrt_kernel.h"
+
+typedef std::chrono::steady_clock ring_clock;
+
+/*
+ * Host side of the command ring read by src/vadd_ring.cpp.
+ *
+ * push() writes a descriptor to the host copy of the ring. flush() transfers
+ * the descriptors pushed since the last flush and only then the new head
+ * count, so the kernel never reads a head that covers a descriptor still on
+ * its way. completed() transfers back the tail count alone, and records()
+ * the completion records.
+ *
+ * Counts are free running, descriptor n goes to slot n % slots. At most
+ * slots descriptors are outstanding, push() fails when the ring is full.
+ */
+class command_ring {
+   public:
+    command_ring(const xrt::device& device, const xrt::kernel& krnl, int slots) : m_slots(slots) {
+        m_bo = xrt::bo(device, RING_WORDS(slots) * sizeof(uint32_t), krnl.group_id(0));
+        m_map = m_bo.map<uint32_t*>();
+        std::fill(m_map, m_map + RING_WORDS(slots), 0);
+        m_bo.sync(XCL_BO_SYNC_BO_TO_DEVICE);
+    }
+
+    xrt::bo& buffer() { return m_bo; }
+    uint32_t pushed() const { return m_head; }
+
+    bool push(uint32_t tag, uint32_t src, uint32_t dst, uint32_t len) {
+        if (m_head - m_tail == (uint32_t)m_slots) return false;
+        uint32_t* desc = m_map + RING_CMDS + (m_head % m_slots) * DESC_WORDS;
+        desc[DESC_TAG] = tag;
+        desc[DESC_SRC] = src;
+        desc[DESC_DST] = dst;
+        desc[DESC_LEN] = len;
+        m_head++;
+        return true;
+    }
+
+    void flush() {
+        if (m_flushed == m_head) return;
+        // In two pieces when the new descriptors wrap around the end of the ring
+        while (m_flushed != m_head) {
+            uint32_t slot = m_flushed % m_slots;
+            uint32_t count = std::min<uint32_t>(m_head - m_flushed, m_slots - slot);
+            m_bo.sync(XCL_BO_SYNC_BO_TO_DEVICE, count * DESC_WORDS * sizeof(uint32_t),
+                      (RING_CMDS + slot * DESC_WORDS) * sizeof(uint32_t));
+            m_flushed += count;
+        }
+        m_map[RING_HEAD] = m_head;
+        m_bo.sync(XCL_BO_SYNC_BO_TO_DEVICE, sizeof(uint32_t), RING_HEAD * sizeof(uint32_t));
+    }
+
+    uint32_t completed() {
+        m_bo.sync(XCL_BO_SYNC_BO_FROM_DEVICE, sizeof(uint32_t), RING_TAIL * sizeof(uint32_t));
+        m_tail = m_map[RING_TAIL];
+        return m_tail;
+    }
+
+    // DONE_WORDS per slot
+    const uint32_t* records() {
+        size_t first = RING_CMDS + m_slots * DESC_WORDS;
+        m_bo.sync(XCL_BO_SYNC_BO_FROM_DEVICE, m_slots * DONE_WORDS * sizeof(uint32_t), first * sizeof(uint32_t));
+        return m_map + first;
+    }
+
+   private:
+    const int m_slots;
+    xrt::bo m_bo;
+    uint32_t* m_map;
+    uint32_t m_head = 0;    // pushed
+    uint32_t m_flushed = 0; // visible to the kernel
+    uint32_t m_tail = 0;    // completed, as last read
+};
+
+int main(int argc, char** argv) {
+    // Command Line Parser
+    sda::utils::CmdLineParser parser;
+
+    // Switches
+    //**************//"<Full Arg>",  "<Short Arg>", "<Description>", "<Default>"
+    parser.addSwitch("--xclbin_file", "-x", "input binary file string", "");
+    parser.addSwitch("--device_id", "-d", "device index", "0");
+    parser.addSwitch("--jobs", "-j", "jobs per measurement", "10000");
+    parser.addSwitch("--job_size", "-s", "integers added by each job", "1024");
+    parser.addSwitch("--slots", "-n", "jobs in flight: ring slots, and runs for per-call launches", "64");
+    parser.parse(argc, argv);
+
+    // Read settings
+    std::string binaryFile = parser.value("xclbin_file");
+    int device_index = stoi(parser.value("device_id"));
+
+    if (argc < 3) {
+        parser.printHelp();
+        return EXIT_FAILURE;
+    }
+
+    int num_jobs = parser.value_to_int("jobs");
+    int job_size = parser.value_to_int("job_size");
+    int slots = parser.value_to_int("slots");
+    if (num_jobs < 1 || job_size < 1 || slots < 1) {
+        parser.printHelp();
+        return EXIT_FAILURE;
+    }
+    if (xcl::is_emulation() && !parser.isValid("jobs")) {
+        num_jobs = 20;
+        std::cout << "Number of jobs is reduced for faster execution on emulation flow.\n";
+    }
+
+    // Every slot has its own operands and result, 4 KB aligned for the sub-buffers of the per-call runs
+    size_t stride = (job_size + 1023) / 1024 * 1024;
+    size_t pool_size_bytes = slots * stride * sizeof(int);
+
+    std::cout << "Open the device" << device_index << std::endl;
+    auto device = xrt::device(device_index);
+    std::cout << "Load the xclbin " << binaryFile << std::endl;
+    auto uuid = device.load_xclbin(binaryFile);
+
+    auto krnl = xrt::kernel(device, uuid, "vadd");
+    auto krnl_ring = xrt::kernel(device, uuid, "vadd_ring");
+
+    std::cout << "Allocate Buffer in Global Memory\n";
+    auto bo_in1 = xrt::bo(device, pool_size_bytes, krnl_ring.group_id(1));
+    auto bo_in2 = xrt::bo(device, pool_size_bytes, krnl_ring.group_id(2));
+    auto bo_out = xrt::bo(device, pool_size_bytes, krnl_ring.group_id(3));
+    auto bo_in1_map = bo_in1.map<int*>();
+    auto bo_in2_map = bo_in2.map<int*>();
+    auto bo_out_map = bo_out.map<int*>();
+    for (size_t i = 0; i < slots * stride; i++) {
+        bo_in1_map[i] = i * 1000003;
+        bo_in2_map[i] = i * 7;
+    }
+    std::cout << "synchronize input buffer data to device global memory\n";
+    bo_in1.sync(XCL_BO_SYNC_BO_TO_DEVICE);
+    bo_in2.sync(XCL_BO_SYNC_BO_TO_DEVICE);
+
+    // Baseline: one prepared run per slot on sub-buffers of the same pools,
+    // started and waited for once per job as in iops_test_xrt
+    std::vector<xrt::run> runs;
+    for (int s = 0; s < slots; s++) {
+        size_t offset = s * stride * sizeof(int);
+        auto run = xrt::run(krnl);
+        run.set_arg(0, xrt::bo(bo_in1, job_size * sizeof(int), offset));
+        run.set_arg(1, xrt::bo(bo_in2, job_size * sizeof(int), offset));
+        run.set_arg(2, xrt::bo(bo_out, job_size * sizeof(int), offset));
+        run.set_arg(3, job_size);
+        runs.push_back(std::move(run));
+    }
+
+    command_ring ring(device, krnl_ring, slots);
+
+    xcl::bench_options bench_opts;
+    if (xcl::is_emulation()) {
+        bench_opts.warmup = 0;
+        bench_opts.repetitions = 1;
+    }
+    xcl::benchmark bench("command_ring_xrt", bench_opts.from_env());
+
+    // Results of the last job of every slot, from either mode
+    auto clear_outputs = [&] {
+        std::fill(bo_out_map, bo_out_map + slots * stride, 0);
+        bo_out.sync(XCL_BO_SYNC_BO_TO_DEVICE);
+    };
+    auto check_outputs = [&](const std::string& mode, int used_slots) {
+        bo_out.sync(XCL_BO_SYNC_BO_FROM_DEVICE);
+        for (int s = 0; s < used_slots; s++) {
+            for (int i = 0; i < job_size; i++) {
+                size_t k = s * stride + i;
+                // The inputs overflow an int, the kernel's sum wraps around
+                uint32_t expected = (uint32_t)bo_in1_map[k] + (uint32_t)bo_in2_map[k];
+                if ((uint32_t)bo_out_map[k] != expected) {
+                    printf("%s: slot %d, element %d is %u, expected %u\n", mode.c_str(), s, i,
+                           (uint32_t)bo_out_map[k], expected);
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+
+    // Throughput with up to slots jobs in flight
+    auto per_call_jobs = [&] {
+        int issued = 0, completed = 0;
+        for (; issued < std::min(num_jobs, slots); issued++) runs[issued].start();
+        for (int s = 0; completed < num_jobs; s = (s + 1) % slots) {
+            runs[s].wait();
+            completed++;
+            if (issued < num_jobs) {
+                runs[s].start();
+                issued++;
+            }
+        }
+    };
+    auto ring_jobs = [&] {
+        uint32_t base = ring.pushed();
+        for (uint32_t pushed = 0, done = 0; done < (uint32_t)num_jobs; done = ring.completed() - base) {
+            for (; pushed < (uint32_t)num_jobs; pushed++) {
+                uint32_t slot = (base + pushed) % slots;
+                if (!ring.push(base + pushed + 1, slot * stride, slot * stride, job_size)) break;
+            }
+            ring.flush();
+        }
+    };
+
+    // Latency of one job at a time, in seconds
+    std::vector<double> per_call_latency, ring_latency;
+    auto per_call_one = [&] {
+        per_call_latency.clear();
+        for (int j = 0; j < num_jobs; j++) {
+            auto start = ring_clock::now();
+            runs[0].start();
+            runs[0].wait();
+            per_call_latency.push_back(std::chrono::duration<double>(ring_clock::now() - start).count());
+        }
+    };
+    auto ring_one = [&] {
+        ring_latency.clear();
+        for (int j = 0; j < num_jobs; j++) {
+            auto start = ring_clock::now();
+            uint32_t n = ring.pushed();
+            ring.push(n + 1, (n % slots) * stride, (n % slots) * stride, job_size);
+            ring.flush();
+            // Every poll transfers the tail count back from the device
+            while (ring.completed() != n + 1) {
+            }
+            ring_latency.push_back(std::chrono::duration<double>(ring_clock::now() - start).count());
+        }
+    };
+
+    bool match = true;
+
+    clear_outputs();
+    xcl::bench_result per_call_result =
+        bench.run("per-call " + std::to_string(slots) + " in flight", per_call_jobs, num_jobs, "jobs/s");
+    bench.run("per-call one at a time", per_call_one, num_jobs, "jobs/s");
+    match = check_outputs("per-call", std::min(num_jobs, slots)) && match;
+
+    // Started once the baseline is done, so that its polling does not load
+    // the memory the per-call runs use. The kernel then restarts by itself
+    // until it is stopped.
+    auto ring_run = krnl_ring(xrt::autostart{0}, ring.buffer(), bo_in1, bo_in2, bo_out, slots);
+    clear_outputs();
+    xcl::bench_result ring_result =
+        bench.run("ring " + std::to_string(slots) + " in flight", ring_jobs, num_jobs, "jobs/s");
+    int ring_slots = std::min<uint32_t>(ring.pushed(), slots);
+    match = check_outputs("ring", ring_slots) && match;
+    // Every slot's record belongs to the last descriptor that used it
+    const uint32_t* records = ring.records();
+    for (int s = 0; s < ring_slots && match; s++) {
+        const uint32_t* record = records + s * DONE_WORDS;
+        uint32_t last = ring.pushed() - 1 - (ring.pushed() - 1 - s) % slots;
+        if (record[DONE_TAG] != last + 1 || record[DONE_LEN] != (uint32_t)job_size) {
+            printf("ring: slot %d completion is tag %u, length %u, expected %u, %d\n", s, record[DONE_TAG],
+                   record[DONE_LEN], last + 1, job_size);
+            match = false;
+        }
+    }
+    bench.run("ring one at a time", ring_one, num_jobs, "jobs/s");
+    ring_run.stop();
+
+    std::sort(per_call_latency.begin(), per_call_latency.end());
+    std::sort(ring_latency.begin(), ring_latency.end());
+    printf("%-10s %12s %10s %10s\n", "Mode", "jobs/s", "p50(us)", "p99(us)");
+    printf("%-10s %12.0f %10.1f %10.1f\n", "per-call", per_call_result.rate(),
+           xcl::bench_percentile(per_call_latency, 0.5) * 1e6, xcl::bench_percentile(per_call_latency, 0.99) * 1e6);
+    printf("%-10s %12.0f %10.1f %10.1f\n", "ring", ring_result.rate(), xcl::bench_percentile(ring_latency, 0.5) * 1e6,
+           xcl::bench_percentile(ring_latency, 0.99) * 1e6);
+    bench.save();
+
+    std::cout << (match ? "TEST PASSED" : "TEST FAILED") << std::endl;
+    return match ? EXIT_SUCCESS : EXIT_FAILURE;
+}
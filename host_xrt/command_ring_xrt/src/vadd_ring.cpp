@@ -0,0 +1,93 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+
+/*******************************************************************************
+Description:
+    Persistent vector addition fed by a command ring in global memory.
+
+    The kernel uses ap_ctrl_chain and is started once by the host in
+    auto-restart mode, so it restarts as soon as it returns without any
+    further start/done handshake with the host. Every invocation reads the
+    head count the host wrote to the ring, runs the descriptors between its
+    own tail count and head, and returns, possibly after doing nothing.
+
+    A descriptor asks for out[dst + i] = in1[src + i] + in2[src + i] for i
+    below len. After each one the kernel writes a completion record in the
+    slot of the descriptor and then the new tail count. The ring, in1 and
+    out share one AXI master, so the host never sees a completion before
+    the result it announces.
+                         ________________
+    Command ring ------>|                |<----- in1, in2 from Global Memory
+    (head, descriptors) |   vadd_ring    |
+                        |                |-----> out to Global Memory
+    Command ring <------|________________|
+    (completions, tail)
+
+*******************************************************************************/
+
+#include <stdint.h>
+#include "vadd_ring.h"
+
+#define DATA_SIZE 4096
+
+// TRIPCOUNT identifiers
+const int c_jobs = 16;
+const int c_len = DATA_SIZE;
+
+extern "C" {
+/*
+    Persistent Vector Addition Kernel
+    Arguments:
+        ring  (input/output) --> Command ring, laid out as in vadd_ring.h
+        in1   (input)        --> Input Vector 1
+        in2   (input)        --> Input Vector 2
+        out   (output)       --> Output Vector
+        slots (input)        --> Number of descriptors the ring holds
+   */
+void vadd_ring(volatile uint32_t* ring, const uint32_t* in1, const uint32_t* in2, uint32_t* out, int slots) {
+#pragma HLS interface ap_ctrl_chain port = return
+#pragma HLS INTERFACE m_axi port = ring bundle = gmem0
+#pragma HLS INTERFACE m_axi port = in1 bundle = gmem0
+#pragma HLS INTERFACE m_axi port = in2 bundle = gmem1
+#pragma HLS INTERFACE m_axi port = out bundle = gmem0
+
+    uint32_t head = ring[RING_HEAD];
+    uint32_t tail = ring[RING_TAIL];
+
+jobs:
+    for (; tail != head; tail++) {
+#pragma HLS LOOP_TRIPCOUNT min = 0 max = c_jobs
+        int slot = tail % slots;
+        volatile uint32_t* desc = ring + RING_CMDS + slot * DESC_WORDS;
+        volatile uint32_t* done = ring + RING_CMDS + slots * DESC_WORDS + slot * DONE_WORDS;
+        uint32_t tag = desc[DESC_TAG];
+        uint32_t src = desc[DESC_SRC];
+        uint32_t dst = desc[DESC_DST];
+        uint32_t len = desc[DESC_LEN];
+
+    // Auto-pipeline is going to apply pipeline to this loop
+    add:
+        for (uint32_t i = 0; i < len; i++) {
+#pragma HLS LOOP_TRIPCOUNT min = c_len max = c_len
+            out[dst + i] = in1[src + i] + in2[src + i];
+        }
+
+        done[DONE_TAG] = tag;
+        done[DONE_LEN] = len;
+        ring[RING_TAIL] = tail + 1;
+    }
+}
+}
@@ -0,0 +1,40 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+#pragma once
+
+// Layout of the command ring shared by host.cpp and vadd_ring.cpp, in 32 bit
+// words. head and tail are free running counts of descriptors, the host
+// writes head and the kernel writes tail; each sits alone in a 64 byte beat
+// so neither side ever transfers the other's word.
+#define RING_HEAD 0
+#define RING_TAIL 16
+#define RING_CMDS 32
+
+// Descriptor: tag, offset of the operands in in1 and in2, offset of the
+// result in out, and length, all in integers
+#define DESC_WORDS 4
+#define DESC_TAG 0
+#define DESC_SRC 1
+#define DESC_DST 2
+#define DESC_LEN 3
+
+// Completion record, after the descriptors: the tag and the length added
+#define DONE_WORDS 2
+#define DONE_TAG 0
+#define DONE_LEN 1
+
+// Words taken by a ring of the given number of slots
+#define RING_WORDS(slots) (RING_CMDS + (slots) * (DESC_WORDS + DONE_WORDS))
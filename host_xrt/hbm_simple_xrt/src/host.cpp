@@ -76,6 +76,8 @@
  *
  *  *****************************************************************************************/
 #include "cmdlineparser.h"
+#include "xclbin_topology.h"
+#include <algorithm>
 #include <iostream>
 #include <cstring>
 
@@ -168,13 +170,31 @@ int main(int argc, char* argv[]) {
     double kernel_time_in_sec = 0, result = 0;
     const int numBuf = 3; // Since three buffers are being used
     int bank_assign[numBuf];
+
+    // The banks each argument can reach come from the xclbin connectivity
+    // rather than being hard-coded
+    xcl::xclbin_topology topology(binaryFile);
+    std::vector<int> shared_banks;
+    for (int b : topology.arg_banks("krnl_vadd_1", 0)) {
+        bool shared = true;
+        for (int j = 1; j < numBuf; j++) {
+            std::vector<int> banks = topology.arg_banks("krnl_vadd_1", j);
+            if (std::find(banks.begin(), banks.end(), b) == banks.end()) shared = false;
+        }
+        if (shared) shared_banks.push_back(b);
+    }
+    if (shared_banks.empty()) {
+        std::cout << "Error: no memory bank is connected to all arguments of krnl_vadd_1" << std::endl;
+        return EXIT_FAILURE;
+    }
+
     for (int j = 0; j < numBuf; j++) {
-        bank_assign[j] = 0;
+        bank_assign[j] = shared_banks[0];
     }
     std::cout << "Running CASE 1  : Single HBM for all three Buffers " << std::endl;
-    std::cout << "input 1 -> bank 0 " << std::endl;
-    std::cout << "input 2 -> bank 0 " << std::endl;
-    std::cout << "output  -> bank 0 " << std::endl;
+    std::cout << "input 1 -> bank " << bank_assign[0] << std::endl;
+    std::cout << "input 2 -> bank " << bank_assign[1] << std::endl;
+    std::cout << "output  -> bank " << bank_assign[2] << std::endl;
 
     kernel_time_in_sec = run_krnl(device, krnl, bank_assign, dataSize);
 
@@ -185,14 +205,15 @@ int main(int argc, char* argv[]) {
 
     std::cout << "[CASE 1] THROUGHPUT = " << result << " GB/s" << std::endl;
 
+    std::vector<int> spread_banks = topology.spread({{"krnl_vadd_1", 0}, {"krnl_vadd_1", 1}, {"krnl_vadd_1", 2}});
     for (int j = 0; j < numBuf; j++) {
-        bank_assign[j] = j + 1;
+        bank_assign[j] = spread_banks[j];
     }
 
     std::cout << "Running CASE 2: Three Separate Banks for Three Buffers" << std::endl;
-    std::cout << "input 1 -> bank 1 " << std::endl;
-    std::cout << "input 2 -> bank 2 " << std::endl;
-    std::cout << "output  -> bank 3 " << std::endl;
+    std::cout << "input 1 -> bank " << bank_assign[0] << std::endl;
+    std::cout << "input 2 -> bank " << bank_assign[1] << std::endl;
+    std::cout << "output  -> bank " << bank_assign[2] << std::endl;
 
     kernel_time_in_sec = run_krnl(device, krnl, bank_assign, dataSize);
 
@@ -119,26 +119,25 @@ int main(int argc, char** argv) {
     // platforms and will return list of devices connected to Xilinx platform
     auto devices = xcl::get_xil_devices();
 
-    // read_binary_file() is a utility API which will load the binaryFile
-    // and will return the pointer to file buffer.
-    auto fileBuf = xcl::read_binary_file(binaryFile);
-    cl::Program::Binaries bins{{fileBuf.data(), fileBuf.size()}};
+    // binary_file maps the binaryFile; program_cache only programs the device
+    // when it does not already hold this xclbin.
+    xcl::binary_file bin(binaryFile);
+    auto& cache = xcl::program_cache::instance();
     bool valid_device = false;
     for (unsigned int i = 0; i < devices.size(); i++) {
         auto device = devices[i];
-        // Creating Context and Command Queue for selected Device
-        OCL_CHECK(err, context = cl::Context(device, nullptr, nullptr, nullptr, &err));
-        OCL_CHECK(err, q = cl::CommandQueue(context, device,
-                                            CL_QUEUE_PROFILING_ENABLE | CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, &err));
-
         std::cout << "Trying to program device[" << i << "]: " << device.getInfo<CL_DEVICE_NAME>() << std::endl;
-        cl::Program program(context, {device}, bins, nullptr, &err);
+        auto program = cache.get(device, bin, &err);
         if (err != CL_SUCCESS) {
             std::cout << "Failed to program device[" << i << "] with xclbin file!\n";
         } else {
             std::cout << "Device[" << i << "]: program successful!\n";
-            OCL_CHECK(err, krnl_chain_mmult = cl::Kernel(program, "krnl_chain_mmult", &err));
-            OCL_CHECK(err, krnl_simple_mmult = cl::Kernel(program, "krnl_simple_mmult", &err));
+            // Command Queue for selected Device on the cached context
+            context = program->context;
+            OCL_CHECK(err, q = cl::CommandQueue(
+                               context, device, CL_QUEUE_PROFILING_ENABLE | CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, &err));
+            OCL_CHECK(err, krnl_chain_mmult = cache.get_kernel(program, "krnl_chain_mmult", &err));
+            OCL_CHECK(err, krnl_simple_mmult = cache.get_kernel(program, "krnl_simple_mmult", &err));
             valid_device = true;
             break; // we break because we found a valid device
         }
@@ -277,6 +276,7 @@ int main(int argc, char** argv) {
     auto elapsed_hs = std::chrono::duration<double>(end_hs - start_hs).count();
     print_summary("krnl_chain_mmult", "krnl_simple_mmult", elapsed_chain, elapsed_hs, NUM_TIMES);
 
+    cache.clear();
     bool test_status = match;
     std::cout << "TEST " << (test_status ? "PASSED" : "FAILED") << std::endl;
     return (test_status ? EXIT_SUCCESS : EXIT_FAILURE);
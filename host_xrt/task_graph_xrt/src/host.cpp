@@ -0,0 +1,240 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+
+#include "bench.h"
+#include "cmdlineparser.h"
+#include "task_graph.h"
+#include "xcl2.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+
+// XRT includes
+#include "experimental/xrt_bo.h"
+#include "experimental/xrt_device.h"
+#include "experimental/xrt_kernel.h"
+
+typedef xcl::task_graph::node node;
+
+// Two vadd runs chained through device memory, like the kernel_chain
+// example: out = (in1 + in2) + in3. Batches are independent of each other.
+static void build_chain(xcl::task_graph& graph,
+                        const xrt::device& device,
+                        const xrt::kernel& krnl,
+                        int batches,
+                        int size,
+                        std::vector<size_t>& mismatches) {
+    size_t vector_size_bytes = sizeof(unsigned int) * size;
+    for (int b = 0; b < batches; b++) {
+        std::string prefix = "chain[" + std::to_string(b) + "] ";
+        auto in1 = xrt::bo(device, vector_size_bytes, krnl.group_id(0));
+        auto in2 = xrt::bo(device, vector_size_bytes, krnl.group_id(1));
+        auto in3 = xrt::bo(device, vector_size_bytes, krnl.group_id(1));
+        auto tmp = xrt::bo(device, vector_size_bytes, krnl.group_id(2));
+        auto out = xrt::bo(device, vector_size_bytes, krnl.group_id(2));
+        auto in1_map = in1.map<unsigned int*>();
+        auto in2_map = in2.map<unsigned int*>();
+        auto in3_map = in3.map<unsigned int*>();
+        for (int i = 0; i < size; i++) {
+            in1_map[i] = i;
+            in2_map[i] = 2 * i + b;
+            in3_map[i] = b * size;
+        }
+
+        auto stage1 = xrt::run(krnl);
+        stage1.set_arg(0, in1);
+        stage1.set_arg(1, in2);
+        stage1.set_arg(2, tmp);
+        stage1.set_arg(3, size);
+        auto stage2 = xrt::run(krnl);
+        stage2.set_arg(0, tmp);
+        stage2.set_arg(1, in3);
+        stage2.set_arg(2, out);
+        stage2.set_arg(3, size);
+
+        node w1 = graph.add_sync(in1, XCL_BO_SYNC_BO_TO_DEVICE, prefix + "write in1");
+        node w2 = graph.add_sync(in2, XCL_BO_SYNC_BO_TO_DEVICE, prefix + "write in2");
+        node w3 = graph.add_sync(in3, XCL_BO_SYNC_BO_TO_DEVICE, prefix + "write in3");
+        node r1 = graph.add_run(stage1, prefix + "vadd 1");
+        node r2 = graph.add_run(stage2, prefix + "vadd 2");
+        node rd = graph.add_sync(out, XCL_BO_SYNC_BO_FROM_DEVICE, prefix + "read out");
+        node check = graph.add_host(
+            [=, &mismatches]() mutable {
+                auto out_map = out.map<unsigned int*>();
+                size_t errors = 0;
+                for (int i = 0; i < size; i++) {
+                    if (out_map[i] != in1_map[i] + in2_map[i] + in3_map[i]) errors++;
+                }
+                mismatches[b] = errors;
+            },
+            prefix + "check");
+        graph.depends(r1, {w1, w2});
+        graph.depends(r2, {r1, w3});
+        graph.depends(rd, r2);
+        graph.depends(check, rd);
+    }
+}
+
+// The krnl_stream_vadd -> krnl_stream_vmult pair of streaming_k2k_mm_xrt:
+// out = (in1 + in2) * in3. Both runs are one node since neither finishes
+// without the other, and the nodes of successive batches are chained as the
+// pair has a single stream between them.
+static void build_stream(xcl::task_graph& graph,
+                         const xrt::device& device,
+                         const xrt::kernel& krnl_vadd,
+                         const xrt::kernel& krnl_vmult,
+                         int batches,
+                         int size,
+                         std::vector<size_t>& mismatches) {
+    size_t vector_size_bytes = sizeof(int) * size;
+    node previous = 0;
+    for (int b = 0; b < batches; b++) {
+        std::string prefix = "stream[" + std::to_string(b) + "] ";
+        auto in1 = xrt::bo(device, vector_size_bytes, krnl_vadd.group_id(0));
+        auto in2 = xrt::bo(device, vector_size_bytes, krnl_vadd.group_id(1));
+        auto in3 = xrt::bo(device, vector_size_bytes, krnl_vmult.group_id(0));
+        auto out = xrt::bo(device, vector_size_bytes, krnl_vmult.group_id(2));
+        auto in1_map = in1.map<int*>();
+        auto in2_map = in2.map<int*>();
+        auto in3_map = in3.map<int*>();
+        for (int i = 0; i < size; i++) {
+            in1_map[i] = i % 1024;
+            in2_map[i] = b;
+            in3_map[i] = i % 7 - 3;
+        }
+
+        auto vadd = xrt::run(krnl_vadd);
+        vadd.set_arg(0, in1);
+        vadd.set_arg(1, in2);
+        vadd.set_arg(3, size);
+        auto vmult = xrt::run(krnl_vmult);
+        vmult.set_arg(0, in3);
+        vmult.set_arg(2, out);
+        vmult.set_arg(3, size);
+
+        node w1 = graph.add_sync(in1, XCL_BO_SYNC_BO_TO_DEVICE, prefix + "write in1");
+        node w2 = graph.add_sync(in2, XCL_BO_SYNC_BO_TO_DEVICE, prefix + "write in2");
+        node w3 = graph.add_sync(in3, XCL_BO_SYNC_BO_TO_DEVICE, prefix + "write in3");
+        node runs = graph.add_runs({vadd, vmult}, prefix + "vadd+vmult");
+        node rd = graph.add_sync(out, XCL_BO_SYNC_BO_FROM_DEVICE, prefix + "read out");
+        node check = graph.add_host(
+            [=, &mismatches]() mutable {
+                auto out_map = out.map<int*>();
+                size_t errors = 0;
+                for (int i = 0; i < size; i++) {
+                    if (out_map[i] != (in1_map[i] + in2_map[i]) * in3_map[i]) errors++;
+                }
+                mismatches[b] = errors;
+            },
+            prefix + "check");
+        graph.depends(runs, {w1, w2, w3});
+        if (b > 0) graph.depends(runs, previous);
+        graph.depends(rd, runs);
+        graph.depends(check, rd);
+        previous = runs;
+    }
+}
+
+int main(int argc, char** argv) {
+    // Command Line Parser
+    sda::utils::CmdLineParser parser;
+
+    // Switches
+    //**************//"<Full Arg>",  "<Short Arg>", "<Description>", "<Default>"
+    parser.addSwitch("--xclbin_file", "-x", "input binary file string", "");
+    parser.addSwitch("--device_id", "-d", "device index", "0");
+    parser.addSwitch("--batches", "-b", "independent batches in each graph", "8");
+    parser.addSwitch("--size", "-s", "integers per buffer", "1048576");
+    parser.addSwitch("--queues", "-q", "queues of the parallel executor", "4");
+    parser.addSwitch("--timeline", "-t", "print the node timings of the last run of each graph", "", true);
+    parser.parse(argc, argv);
+
+    // Read settings
+    std::string binaryFile = parser.value("xclbin_file");
+    int device_index = stoi(parser.value("device_id"));
+
+    if (argc < 3) {
+        parser.printHelp();
+        return EXIT_FAILURE;
+    }
+
+    int batches = parser.value_to_int("batches");
+    int size = parser.value_to_int("size");
+    int queues = parser.value_to_int("queues");
+    bool timeline = parser.value_to_bool("timeline");
+    if (batches < 1 || size < 1 || queues < 1) {
+        parser.printHelp();
+        return EXIT_FAILURE;
+    }
+    if (xcl::is_emulation() && !parser.isValid("size")) {
+        size = 4096;
+        std::cout << "Buffer size is reduced for faster execution on emulation flow.\n";
+    }
+
+    std::cout << "Open the device" << device_index << std::endl;
+    auto device = xrt::device(device_index);
+    std::cout << "Load the xclbin " << binaryFile << std::endl;
+    auto uuid = device.load_xclbin(binaryFile);
+
+    auto krnl_vadd = xrt::kernel(device, uuid, "vadd");
+    auto krnl_stream_vadd = xrt::kernel(device, uuid, "krnl_stream_vadd");
+    auto krnl_stream_vmult = xrt::kernel(device, uuid, "krnl_stream_vmult");
+
+    std::cout << "Build the task graphs\n";
+    std::vector<size_t> chain_mismatches(batches), stream_mismatches(batches);
+    xcl::task_graph chain, stream;
+    build_chain(chain, device, krnl_vadd, batches, size, chain_mismatches);
+    build_stream(stream, device, krnl_stream_vadd, krnl_stream_vmult, batches, size, stream_mismatches);
+
+    xcl::bench_options bench_opts;
+    if (xcl::is_emulation()) {
+        bench_opts.warmup = 0;
+        bench_opts.repetitions = 1;
+    }
+    xcl::benchmark bench("task_graph_xrt", bench_opts.from_env());
+
+    struct graph_case {
+        std::string name;
+        const xcl::task_graph* graph;
+        std::vector<size_t>* mismatches;
+    };
+    std::vector<graph_case> cases = {{"chain", &chain, &chain_mismatches}, {"stream", &stream, &stream_mismatches}};
+    xcl::task_executor serial(1), parallel(queues);
+
+    bool match = true;
+    printf("%-8s %7s %10s %10s %13s %8s %12s\n", "Graph", "Queues", "wall(ms)", "busy(ms)", "critical(ms)",
+           "overlap", "batches/s");
+    for (auto& c : cases) {
+        for (xcl::task_executor* executor : {&serial, &parallel}) {
+            xcl::task_report report;
+            std::fill(c.mismatches->begin(), c.mismatches->end(), (size_t)-1);
+            auto& result = bench.run(c.name + " " + std::to_string(executor->queues()) + " queues",
+                                     [&] { report = executor->execute(*c.graph); }, batches, "batches/s");
+            for (int b = 0; b < batches; b++) {
+                if ((*c.mismatches)[b] == 0) continue;
+                printf("%s: batch %d has %zu mismatching integers\n", c.name.c_str(), b, (*c.mismatches)[b]);
+                match = false;
+            }
+            printf("%-8s %7u %10.3f %10.3f %13.3f %8.2f %12.1f\n", c.name.c_str(), executor->queues(),
+                   report.wall_ms, report.busy_ms, report.critical_ms, report.overlap(), result.rate());
+            if (timeline) report.print(*c.graph, std::cout);
+        }
+    }
+    bench.save();
+
+    std::cout << (match ? "TEST PASSED" : "TEST FAILED") << std::endl;
+    return match ? EXIT_SUCCESS : EXIT_FAILURE;
+}
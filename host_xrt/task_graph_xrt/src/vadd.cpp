@@ -0,0 +1,118 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+
+/*******************************************************************************
+Description:
+    This example uses the load/compute/store coding style, which is generally
+    the most efficient for implementing kernels using HLS. The load and store
+    functions are responsible for moving data in and out of the kernel as
+    efficiently as possible. The core functionality is decomposed across one
+    of more compute functions. Whenever possible, the compute function should
+    pass data through HLS streams and should contain a single set of nested loops.
+    HLS stream objects are used to pass data between producer and consumer
+    functions. Stream read and write operations have a blocking behavior which
+    allows consumers and producers to synchronize with each other automatically.
+    The dataflow pragma instructs the compiler to enable task-level pipelining.
+    This is required for to load/compute/store functions to execute in a parallel
+    and pipelined manner.
+    The kernel loads, computes and stores one integer per clock cycle, which
+    uses 4 of the 64 bytes a kernel port can carry. It is a good practice to
+    match the compute bandwidth to the I/O bandwidth; performance/vadd_wide
+    shows the same kernel on hls::vector types that fill the port. The kernel
+    is implemented as below:
+                                       _____________
+                                      |             |<----- Input Vector 1 from Global Memory
+                                      |  load_input |       __
+                                      |_____________|----->|  |
+                                       _____________       |  | in1_stream
+Input Vector 2 from Global Memory --->|             |      |__|
+                               __     |  load_input |        |
+                              |  |<---|_____________|        |
+                   in2_stream |  |     _____________         |
+                              |__|--->|             |<--------
+                                      | compute_add |      __
+                                      |_____________|---->|  |
+                                       ______________     |  | out_stream
+                                      |              |<---|__|
+                                      | store_result |
+                                      |______________|-----> Output result to Global Memory
+
+*******************************************************************************/
+
+#include <stdint.h>
+#include <hls_stream.h>
+
+#define DATA_SIZE 4096
+
+// TRIPCOUNT identifier
+const int c_size = DATA_SIZE;
+
+static void read_input(unsigned int* in, hls::stream<unsigned int>& inStream, int size) {
+// Auto-pipeline is going to apply pipeline to this loop
+mem_rd:
+    for (int i = 0; i < size; i++) {
+#pragma HLS LOOP_TRIPCOUNT min = c_size max = c_size
+        inStream << in[i];
+    }
+}
+
+static void compute_add(hls::stream<unsigned int>& inStream1,
+                        hls::stream<unsigned int>& inStream2,
+                        hls::stream<unsigned int>& outStream,
+                        int size) {
+// Auto-pipeline is going to apply pipeline to this loop
+execute:
+    for (int i = 0; i < size; i++) {
+#pragma HLS LOOP_TRIPCOUNT min = c_size max = c_size
+        outStream << (inStream1.read() + inStream2.read());
+    }
+}
+
+static void write_result(unsigned int* out, hls::stream<unsigned int>& outStream, int size) {
+// Auto-pipeline is going to apply pipeline to this loop
+mem_wr:
+    for (int i = 0; i < size; i++) {
+#pragma HLS LOOP_TRIPCOUNT min = c_size max = c_size
+        out[i] = outStream.read();
+    }
+}
+
+extern "C" {
+/*
+    Vector Addition Kernel Implementation using dataflow
+    Arguments:
+        in1   (input)  --> Input Vector 1
+        in2   (input)  --> Input Vector 2
+        out  (output) --> Output Vector
+        size (input)  --> Size of Vector in Integer
+   */
+void vadd(unsigned int* in1, unsigned int* in2, unsigned int* out, int size) {
+    static hls::stream<unsigned int> inStream1("input_stream_1");
+    static hls::stream<unsigned int> inStream2("input_stream_2");
+    static hls::stream<unsigned int> outStream("output_stream");
+
+#pragma HLS INTERFACE m_axi port = in1 bundle = gmem0
+#pragma HLS INTERFACE m_axi port = in2 bundle = gmem1
+#pragma HLS INTERFACE m_axi port = out bundle = gmem0
+
+#pragma HLS dataflow
+    // dataflow pragma instruct compiler to run following three APIs in parallel
+    read_input(in1, inStream1, size);
+    read_input(in2, inStream2, size);
+    compute_add(inStream1, inStream2, outStream, size);
+    write_result(out, outStream, size);
+}
+}
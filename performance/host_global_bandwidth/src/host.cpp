@@ -15,12 +15,16 @@
 */
 
 #include <CL/opencl.h>
+#include <algorithm>
 #include <chrono>
 #include <ctime>
 #include <fstream>
 #include <iostream>
 #include <vector>
 
+#include "bench.h"
+#include "cmdlineparser.h"
+#include "perf_counters.h"
 #include "xcl2.hpp"
 
 double throput_max_host_to_dev[3] = {0};
@@ -28,33 +32,40 @@ double throput_max_dev_to_host[3] = {0};
 double throput_max_bidirectional[3] = {0};
 
 ////////////////////////////////////////////////////////////////////////////////
-class Timer {
-    std::chrono::high_resolution_clock::time_point mTimeStart;
-
-   public:
-    Timer() { reset(); }
-    long long stop() {
-        std::chrono::high_resolution_clock::time_point timeEnd = std::chrono::high_resolution_clock::now();
-        return std::chrono::duration_cast<std::chrono::microseconds>(timeEnd - mTimeStart).count();
-    }
-    void reset() { mTimeStart = std::chrono::high_resolution_clock::now(); }
-};
-
-static int host_to_dev(cl::CommandQueue commands, int buff_size, std::vector<cl::Memory>& mems, std::ostream& strm) {
-    cl_int err;
-    Timer timer;
-    OCL_CHECK(err, err = commands.enqueueMigrateMemObjects(mems, 0 /* 0 means from host*/));
+// Name of a sweep point in the benchmark report, e.g. "host_to_dev 64 KB x 1024"
+static std::string point_name(const char* direction, size_t buff_size, size_t count) {
+    return std::string(direction) + " " + xcl::convert_size(buff_size) + " x " + std::to_string(count);
+}
 
-    commands.finish();
+// Host side counters of a sweep point, per migration (warmup included)
+static void print_counters(const xcl::perf_counters& counters, const xcl::benchmark& bench) {
+    if (!counters.available()) return;
+    const xcl::bench_options& opts = bench.options();
+    std::cout << "    Host per migration: " << counters.summary(opts.warmup + opts.repetitions) << "\n";
+}
 
-    double timer_stop2 = timer.stop();
-    double throput = (double)(buff_size * mems.size());
-    throput *= 1000000;     // convert us to s;
-    throput /= 1024 * 1024; // convert to MB
-    throput /= timer_stop2;
+static int host_to_dev(xcl::benchmark& bench,
+                       xcl::perf_counters& counters,
+                       cl::CommandQueue commands,
+                       size_t buff_size,
+                       std::vector<cl::Memory>& mems,
+                       std::ostream& strm) {
+    cl_int err = CL_SUCCESS;
+    double total_mb = (double)buff_size * mems.size() / (1024 * 1024);
+    counters.start();
+    auto& result = bench.run(point_name("host_to_dev", buff_size, mems.size()),
+                             [&] {
+                                 OCL_CHECK(err, err = commands.enqueueMigrateMemObjects(mems, 0 /* 0 means from host*/));
+                                 commands.finish();
+                             },
+                             total_mb, "MB/s");
+    counters.stop();
+
+    double throput = result.rate();
     double dbuff_size = (double)(buff_size) / 1024; // convert to KB
     std::cout << "OpenCL migration BW host to device: " << throput << " MB/s"
               << " for buffer size " << dbuff_size << " KB with " << mems.size() << " buffers\n";
+    print_counters(counters, bench);
     strm << "Host to Card, " << dbuff_size << " KB, " << mems.size() << ", " << throput << "\n";
 
     if (throput > throput_max_host_to_dev[0]) {
@@ -62,58 +73,79 @@ static int host_to_dev(cl::CommandQueue commands, int buff_size, std::vector<cl:
         throput_max_host_to_dev[1] = dbuff_size;
         throput_max_host_to_dev[2] = mems.size();
     }
-    return CL_SUCCESS;
+    return err;
 }
 
-static int dev_to_host(cl::CommandQueue commands, int buff_size, std::vector<cl::Memory>& mems, std::ostream& strm) {
-    cl_int err;
-    Timer timer;
-    OCL_CHECK(err, err = commands.enqueueMigrateMemObjects(mems, CL_MIGRATE_MEM_OBJECT_HOST));
-
-    commands.finish();
-
-    long long timer_stop2 = timer.stop();
-    double throput = (double)(buff_size * mems.size());
-    throput *= 1000000;     // convert us to s;
-    throput /= 1024 * 1024; // convert to MB
-    throput /= timer_stop2;
+static int dev_to_host(xcl::benchmark& bench,
+                       xcl::perf_counters& counters,
+                       cl::CommandQueue commands,
+                       size_t buff_size,
+                       std::vector<cl::Memory>& mems,
+                       std::ostream& strm) {
+    cl_int err = CL_SUCCESS;
+    double total_mb = (double)buff_size * mems.size() / (1024 * 1024);
+    counters.start();
+    auto& result = bench.run(point_name("dev_to_host", buff_size, mems.size()),
+                             [&] {
+                                 OCL_CHECK(err,
+                                           err = commands.enqueueMigrateMemObjects(mems, CL_MIGRATE_MEM_OBJECT_HOST));
+                                 commands.finish();
+                             },
+                             total_mb, "MB/s");
+    counters.stop();
+
+    double throput = result.rate();
     double dbuff_size = (double)(buff_size) / 1024; // convert to KB
     std::cout << "OpenCL migration BW device to host: " << throput << " MB/s"
               << " for buffer size " << dbuff_size << " KB with " << mems.size() << " buffers\n";
+    print_counters(counters, bench);
     strm << "Card to Host, " << dbuff_size << " KB, " << mems.size() << ", " << throput << "\n";
     if (throput > throput_max_dev_to_host[0]) {
         throput_max_dev_to_host[0] = throput;
         throput_max_dev_to_host[1] = dbuff_size;
         throput_max_dev_to_host[2] = mems.size();
     }
-    return CL_SUCCESS;
+    return err;
 }
 
-static int bidirectional(cl::CommandQueue commands,
-                         int buff_size,
+static int bidirectional(xcl::benchmark& bench,
+                         xcl::perf_counters& counters,
+                         cl::CommandQueue commands,
+                         size_t buff_size,
                          std::vector<cl::Memory>& mems1,
                          std::vector<cl::Memory>& mems2,
                          std::ostream& strm) {
-    cl_int err;
-    // Writing to avoid read-without-write case in DDR
-    OCL_CHECK(err, err = commands.enqueueMigrateMemObjects(mems2, 0 /* 0 means from host*/));
-    commands.finish();
-
-    Timer timer;
-    OCL_CHECK(err, err = commands.enqueueMigrateMemObjects(mems1, 0 /* 0 means from host*/));
-    OCL_CHECK(err, err = commands.enqueueMigrateMemObjects(mems2, CL_MIGRATE_MEM_OBJECT_HOST));
-
-    commands.finish();
-
-    long long timer_stop2 = timer.stop();
-    double throput = (double)(buff_size * (mems1.size() + mems2.size()));
-    throput *= 1000000;     // convert us to s;
-    throput /= 1024 * 1024; // convert to MB
-    throput /= timer_stop2;
+    cl_int err = CL_SUCCESS;
+    double total_mb = (double)buff_size * (mems1.size() + mems2.size()) / (1024 * 1024);
+    // The body times itself so the preparation of mems2 stays out of the
+    // measurement, and the counters only run over the timed part as well
+    counters.start();
+    counters.pause();
+    auto& result = bench.run(point_name("bidirectional", buff_size, mems1.size()),
+                             [&] {
+                                 // Writing to avoid read-without-write case in DDR
+                                 OCL_CHECK(err, err = commands.enqueueMigrateMemObjects(mems2, 0));
+                                 commands.finish();
+
+                                 counters.resume();
+                                 auto start = std::chrono::high_resolution_clock::now();
+                                 OCL_CHECK(err, err = commands.enqueueMigrateMemObjects(mems1, 0));
+                                 OCL_CHECK(err,
+                                           err = commands.enqueueMigrateMemObjects(mems2, CL_MIGRATE_MEM_OBJECT_HOST));
+                                 commands.finish();
+                                 auto end = std::chrono::high_resolution_clock::now();
+                                 counters.pause();
+                                 return std::chrono::duration<double>(end - start).count();
+                             },
+                             total_mb, "MB/s");
+    counters.stop();
+
+    double throput = result.rate();
     double dbuff_size = (double)(buff_size) / 1024; // convert to KB
     std::cout << "OpenCL migration BW "
               << "overall: " << throput << " MB/s for buffer size " << dbuff_size << " KB with " << mems1.size()
               << " buffers\n";
+    print_counters(counters, bench);
     strm << "Card to Host, " << dbuff_size << " KB, " << mems1.size() << ", " << throput << "\n";
 
     if (throput > throput_max_bidirectional[0]) {
@@ -121,22 +153,52 @@ static int bidirectional(cl::CommandQueue commands,
         throput_max_bidirectional[1] = dbuff_size;
         throput_max_bidirectional[2] = mems1.size();
     }
-    return CL_SUCCESS;
+    return err;
 }
 
 int main(int argc, char** argv) {
-    if (argc != 2) {
-        std::cout << "Usage: " << argv[0] << " <XCLBIN File>" << std::endl;
+    // Command Line Parser
+    sda::utils::CmdLineParser parser;
+
+    // Switches
+    //**************//"<Full Arg>",  "<Short Arg>", "<Description>", "<Default>"
+    parser.addSwitch("--xclbin_file", "-x", "input binary file string", "");
+    parser.addSwitch("--buffer_size", "-s", "buffer sizes to sweep, e.g. 4K:256M:x2 (default: built-in table)", "");
+    parser.addSwitch("--buffer_count", "-c", "buffer counts to sweep, e.g. 8,64,256 (default: built-in table)", "");
+    parser.addSwitch("--perf_events", "-p", "report host perf_event counters of each sweep point", "", true);
+    parser.parse(argc, argv);
+
+    // Read settings
+    std::string binaryFile = parser.value("xclbin_file");
+    if (binaryFile.empty()) {
+        parser.printHelp();
         return EXIT_FAILURE;
     }
 
-    std::string binaryFile = argv[1];
-
     // Variable-------------------------------------------------------------------------------
 
-    int buff_tab[][2] = {{64, 1024},    {256, 1024},    {512, 1024},    {1024, 1024},   {4096, 1024},
-                         {16384, 512},  {1048576, 8},   {1048576, 64},  {1048576, 256}, {2097152, 8},
-                         {2097152, 64}, {2097152, 256}, {16777216, 64}, {268435456, 4}, {536870912, 2}};
+    // Sweep points as {buffer size, buffer count}
+    std::vector<std::pair<size_t, size_t> > points = {
+        {64, 1024},      {256, 1024},     {512, 1024},      {1024, 1024},     {4096, 1024},
+        {16384, 512},    {1048576, 8},    {1048576, 64},    {1048576, 256},   {2097152, 8},
+        {2097152, 64},   {2097152, 256},  {16777216, 64},   {268435456, 4},   {536870912, 2}};
+    if (parser.isValid("buffer_size") || parser.isValid("buffer_count")) {
+        // Every combination of the two sweeps; a missing one stays at a single value
+        std::vector<uint64_t> sizes(1, 1024 * 1024), counts(1, 64);
+        if (parser.isValid("buffer_size")) sizes = parser.value_to_sweep("buffer_size");
+        if (parser.isValid("buffer_count")) counts = parser.value_to_sweep("buffer_count");
+        if (sizes.empty() || counts.empty() || std::count(sizes.begin(), sizes.end(), 0) ||
+            std::count(counts.begin(), counts.end(), 0)) {
+            parser.printHelp();
+            return EXIT_FAILURE;
+        }
+        points.clear();
+        for (auto size : sizes) {
+            for (auto count : counts) points.push_back({size, count});
+        }
+    } else if (xcl::is_emulation()) {
+        points.resize(2); // Reducing combinations to run faster in emulation flow
+    }
 
     cl_int err;
     cl::Context context;
@@ -163,6 +225,12 @@ int main(int argc, char** argv) {
         } else {
             std::cout << "Device[" << i << "]: program successful!\n";
             OCL_CHECK(err, krnl_bandwidth = cl::Kernel(program, "bandwidth", &err));
+            // Keep this thread, and the host side buffers the runtime allocates
+            // from it, on the NUMA node the card is attached to.
+            int node = xcl::get_numa_node(device);
+            if (node >= 0 && xcl::bind_thread_to_node(node)) {
+                std::cout << "Host thread bound to NUMA node " << node << std::endl;
+            }
             valid_device = true;
             break; // we break because we found a valid device
         }
@@ -172,23 +240,36 @@ int main(int argc, char** argv) {
         exit(EXIT_FAILURE);
     }
 
-    int dim1 = sizeof(buff_tab) / (2 * 4);
-    if (xcl::is_emulation()) {
-        dim1 = 2; // Reducing combinations to run faster in emulation flow
-    }
+    // Every sweep point is measured after a warmup and reported by its median
+    // repetition; XCL_BENCH_JSON/XCL_BENCH_CSV save the full statistics.
+    xcl::bench_options bench_opts;
+    bench_opts.repetitions = xcl::is_emulation() ? 1 : 5;
+    xcl::benchmark bench("host_global_bandwidth", bench_opts.from_env());
+    xcl::perf_counters counters(parser.value_to_bool("perf_events"));
 
     std::ofstream handle("metric1.csv");
     handle << "Direction, Buffer Size (bytes), Count, Bandwidth (MB/s)\n";
 
-    for (int buff_size_1 = 0; buff_size_1 < dim1; buff_size_1++) {
-        int nxtcnt = buff_tab[buff_size_1][0];
-        int buff_cnt = buff_tab[buff_size_1][1];
+    // Buffers are recycled across sweep points and between the two sweeps, so
+    // device allocations and fills are kept out of the measured transfers.
+    // A buffer is placed on the bank of the kernel argument it is first set
+    // on, so each argument gets its own pool and a reused buffer never ends
+    // up on the other argument's bank. Each pool keeps at most 2 GB around.
+    xcl::buffer_pool pool(context, 2UL << 30);
+    xcl::buffer_pool pool_arg1(context, 2UL << 30);
+
+    for (auto& point : points) {
+        size_t nxtcnt = point.first;
+        size_t buff_cnt = point.second;
         std::vector<cl::Memory> mems(buff_cnt);
 
-        for (int i = buff_cnt - 1; i >= 0; i--) {
-            OCL_CHECK(err, mems[i] = cl::Buffer(context, (cl_mem_flags)(CL_MEM_READ_WRITE), nxtcnt, nullptr, &err));
-            OCL_CHECK(err, err = krnl_bandwidth.setArg(0, mems[i]));
-            OCL_CHECK(err, err = command_queue.enqueueFillBuffer<int>((cl::Buffer&)mems[i], i, 0, nxtcnt, 0, 0));
+        for (size_t i = buff_cnt; i-- > 0;) {
+            bool fresh;
+            OCL_CHECK(err, mems[i] = pool.acquire(nxtcnt, CL_MEM_READ_WRITE, -1, &fresh, &err));
+            if (fresh) {
+                OCL_CHECK(err, err = krnl_bandwidth.setArg(0, mems[i]));
+                OCL_CHECK(err, err = command_queue.enqueueFillBuffer<int>((cl::Buffer&)mems[i], i, 0, nxtcnt, 0, 0));
+            }
         }
 
         if (err != CL_SUCCESS) {
@@ -197,31 +278,37 @@ int main(int argc, char** argv) {
 
         command_queue.finish();
 
-        err = host_to_dev(command_queue, nxtcnt, mems, handle);
+        err = host_to_dev(bench, counters, command_queue, nxtcnt, mems, handle);
         if (err != CL_SUCCESS) {
             break;
         }
 
-        err = dev_to_host(command_queue, nxtcnt, mems, handle);
+        err = dev_to_host(bench, counters, command_queue, nxtcnt, mems, handle);
         if (err != CL_SUCCESS) {
             break;
         }
+        pool.release_all(mems);
     }
 
     printf("\nThe bandwidth numbers for bidirectional case:\n");
-    for (int buff_size_1 = 0; buff_size_1 < dim1; buff_size_1++) {
-        int nxtcnt = buff_tab[buff_size_1][0];
-        int buff_cnt = buff_tab[buff_size_1][1];
+    for (auto& point : points) {
+        size_t nxtcnt = point.first;
+        size_t buff_cnt = point.second;
         std::vector<cl::Memory> mems1(buff_cnt);
         std::vector<cl::Memory> mems2(buff_cnt);
 
-        for (int i = buff_cnt - 1; i >= 0; i--) {
-            OCL_CHECK(err, mems1[i] = cl::Buffer(context, (cl_mem_flags)(CL_MEM_READ_WRITE), nxtcnt, nullptr, &err));
-            OCL_CHECK(err, err = krnl_bandwidth.setArg(0, mems1[i]));
-            OCL_CHECK(err, err = command_queue.enqueueFillBuffer<int>((cl::Buffer&)mems1[i], i, 0, nxtcnt, 0, 0));
-            OCL_CHECK(err, mems2[i] = cl::Buffer(context, (cl_mem_flags)(CL_MEM_READ_WRITE), nxtcnt, nullptr, &err));
-            OCL_CHECK(err, err = krnl_bandwidth.setArg(1, mems2[i]));
-            OCL_CHECK(err, err = command_queue.enqueueFillBuffer<int>((cl::Buffer&)mems2[i], i, 0, nxtcnt, 0, 0));
+        for (size_t i = buff_cnt; i-- > 0;) {
+            bool fresh;
+            OCL_CHECK(err, mems1[i] = pool.acquire(nxtcnt, CL_MEM_READ_WRITE, -1, &fresh, &err));
+            if (fresh) {
+                OCL_CHECK(err, err = krnl_bandwidth.setArg(0, mems1[i]));
+                OCL_CHECK(err, err = command_queue.enqueueFillBuffer<int>((cl::Buffer&)mems1[i], i, 0, nxtcnt, 0, 0));
+            }
+            OCL_CHECK(err, mems2[i] = pool_arg1.acquire(nxtcnt, CL_MEM_READ_WRITE, -1, &fresh, &err));
+            if (fresh) {
+                OCL_CHECK(err, err = krnl_bandwidth.setArg(1, mems2[i]));
+                OCL_CHECK(err, err = command_queue.enqueueFillBuffer<int>((cl::Buffer&)mems2[i], i, 0, nxtcnt, 0, 0));
+            }
         }
 
         if (err != CL_SUCCESS) {
@@ -230,11 +317,18 @@ int main(int argc, char** argv) {
 
         command_queue.finish();
         // printf("\nThe bandwidth numbers for bidirectional case:\n");
-        err = bidirectional(command_queue, nxtcnt, mems1, mems2, handle);
+        err = bidirectional(bench, counters, command_queue, nxtcnt, mems1, mems2, handle);
         if (err != CL_SUCCESS) {
             break;
         }
+        pool.release_all(mems1);
+        pool_arg1.release_all(mems2);
     }
+    pool.print_stats("Buffer pool (arg 0)");
+    pool_arg1.print_stats("Buffer pool (arg 1)");
+    printf("\n");
+    bench.print_summary();
+    bench.save();
 
     std::cout << "\nMaximum bandwidth achieved :\n";
     std::cout << "OpenCL migration BW host to device: " << throput_max_host_to_dev[0] << " MB/s"
@@ -14,20 +14,42 @@
 * under the License.
 */
 
+#include "cmdlineparser.h"
+#include "fastmem.h"
 #include "xcl2.hpp"
 #include <CL/cl_ext_xilinx.h>
+#include <algorithm>
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cout << "Usage: " << argv[0] << " <xclbin>" << std::endl;
+    // Command Line Parser
+    sda::utils::CmdLineParser parser;
+
+    // Switches
+    //**************//"<Full Arg>",  "<Short Arg>", "<Description>", "<Default>"
+    parser.addSwitch("--xclbin_file", "-x", "input binary file string", "");
+    parser.addSwitch("--buffer_size", "-s", "buffer sizes to sweep, e.g. 4K:256M:x2 or 1M,64M", "4K:256M:x2");
+    parser.parse(argc, argv);
+
+    // Read settings
+    std::string binaryFile = parser.value("xclbin_file");
+    std::vector<uint64_t> buffer_sizes = parser.value_to_sweep("buffer_size");
+    if (binaryFile.empty() || buffer_sizes.empty() || std::count(buffer_sizes.begin(), buffer_sizes.end(), 0)) {
+        parser.printHelp();
         return EXIT_FAILURE;
     }
+    // The kernels move whole 4 KB bursts up to 8 KB and whole 64 byte words
+    // above, any other size would move fewer bytes than the bandwidth assumes
+    for (auto size : buffer_sizes) {
+        if (size % 4096 != 0) {
+            std::cout << "Buffer size " << size << " is not a multiple of 4 KB, which the kernels require\n";
+            return EXIT_FAILURE;
+        }
+    }
 
     cl_int err;
     cl::Context context;
     cl::CommandQueue q;
     cl::Kernel krnl, krnl_read, krnl_write;
-    std::string binaryFile = argv[1];
 
     // The get_xil_devices will return vector of Xilinx Devices
     auto devices = xcl::get_xil_devices();
@@ -65,13 +87,13 @@ int main(int argc, char* argv[]) {
     double read_max = 0;
     double write_max = 0;
 
-    for (size_t i = 4 * 1024; i <= 256 * 1024 * 1024; i *= 2) {
+    for (size_t bufsize : buffer_sizes) {
         size_t iter = 1024;
-        size_t bufsize = i;
 
         if (xcl::is_emulation()) {
             iter = 2;
-            if (bufsize > 8 * 1024) break;
+            // Only the default sweep is cut short to run faster in emulation flow
+            if (!parser.isValid("buffer_size") && bufsize > 8 * 1024) break;
         }
 
         /* Input buffer */
@@ -82,9 +104,7 @@ int main(int argc, char* argv[]) {
             return EXIT_FAILURE;
         }
 
-        for (size_t i = 0; i < bufsize; i++) {
-            input_host[i] = i % 256;
-        }
+        xcl::fast_fill_ramp(input_host, bufsize);
         cl::Buffer* buffer[2];
 
         /* Host mem flags */
@@ -119,9 +139,7 @@ int main(int argc, char* argv[]) {
         OCL_CHECK(err, err = q.finish());
 
         /* prepare data to be written to the device */
-        for (size_t i = 0; i < bufsize; i++) {
-            map_input_buffer0[i] = input_host[i];
-        }
+        xcl::fast_copy(map_input_buffer0, input_host, bufsize);
         OCL_CHECK(err, err = q.enqueueUnmapMemObject(*(buffer[0]), map_input_buffer0));
 
         OCL_CHECK(err, err = q.finish());
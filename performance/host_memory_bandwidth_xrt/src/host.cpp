@@ -16,6 +16,7 @@
 
 #include "xcl2.hpp"
 #include "cmdlineparser.h"
+#include "perf_counters.h"
 #include <cstring>
 #include <iostream>
 
@@ -32,6 +33,7 @@ int main(int argc, char* argv[]) {
     //**************//"<Full Arg>",  "<Short Arg>", "<Description>", "<Default>"
     parser.addSwitch("--xclbin_file", "-x", "input binary file string", "");
     parser.addSwitch("--device_id", "-d", "device index", "0");
+    parser.addSwitch("--perf_events", "-p", "report host perf_event counters of each kernel run", "", true);
     parser.parse(argc, argv);
 
     // Read settings
@@ -52,6 +54,8 @@ int main(int argc, char* argv[]) {
     auto krnl_read = xrt::kernel(device, uuid, "read_bandwidth");
     auto krnl_write = xrt::kernel(device, uuid, "write_bandwidth");
 
+    xcl::perf_counters counters(parser.value_to_bool("perf_events"));
+
     double concurrent_max = 0;
     double read_max = 0;
     double write_max = 0;
@@ -96,10 +100,12 @@ int main(int argc, char* argv[]) {
             bo_in_map[i] = input_host[i];
         }
 
+        counters.start();
         auto start = std::chrono::high_resolution_clock::now();
         auto run = krnl(hostonly_bo_in, hostonly_bo_out, bufsize, iter);
         run.wait();
         auto end = std::chrono::high_resolution_clock::now();
+        counters.stop();
         double duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
         double msduration = duration / iter;
 
@@ -114,15 +120,18 @@ int main(int argc, char* argv[]) {
 
         std::cout << "Concurrent Read and Write Throughput = " << gbpersec << " (GB/sec) for buffer size " << size_str
                   << std::endl;
+        if (counters.available()) std::cout << "    Host during run: " << counters.summary() << std::endl;
 
         if (gbpersec > concurrent_max) {
             concurrent_max = gbpersec;
         }
 
+        counters.start();
         start = std::chrono::high_resolution_clock::now();
         auto run_read = krnl_read(hostonly_bo_in, bufsize, iter);
         run_read.wait();
         end = std::chrono::high_resolution_clock::now();
+        counters.stop();
         duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
         msduration = duration / iter;
 
@@ -132,15 +141,18 @@ int main(int argc, char* argv[]) {
         gbpersec = (bpersec) / ((double)1024 * 1024 * 1024);
 
         std::cout << "Read Throughput = " << gbpersec << " (GB/sec) for buffer size " << size_str << std::endl;
+        if (counters.available()) std::cout << "    Host during run: " << counters.summary() << std::endl;
 
         if (gbpersec > read_max) {
             read_max = gbpersec;
         }
 
+        counters.start();
         start = std::chrono::high_resolution_clock::now();
         auto run_write = krnl_write(hostonly_bo_out, bufsize, iter);
         run_write.wait();
         end = std::chrono::high_resolution_clock::now();
+        counters.stop();
         duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
         msduration = duration / iter;
 
@@ -149,7 +161,9 @@ int main(int argc, char* argv[]) {
         bpersec = (dbytes / dsduration);
         gbpersec = (bpersec) / ((double)1024 * 1024 * 1024);
 
-        std::cout << "Write Throughput = " << gbpersec << " (GB/sec) for buffer size " << size_str << "\n\n";
+        std::cout << "Write Throughput = " << gbpersec << " (GB/sec) for buffer size " << size_str << "\n";
+        if (counters.available()) std::cout << "    Host during run: " << counters.summary() << "\n";
+        std::cout << "\n";
 
         if (gbpersec > write_max) {
             write_max = gbpersec;
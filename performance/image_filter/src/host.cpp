@@ -0,0 +1,222 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+
+#include "bench.h"
+#include "bitmap.h"
+#include "cmdlineparser.h"
+#include "pixel_pack.h"
+#include "xcl2.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// XRT includes
+#include "experimental/xrt_bo.h"
+#include "experimental/xrt_device.h"
+#include "experimental/xrt_kernel.h"
+
+// Must match src/image_filter.cpp
+#define MAX_WIDTH 4096
+#define FILTER_SOBEL 0
+#define FILTER_GAUSSIAN3 1
+#define FILTER_GAUSSIAN5 2
+
+static const char* filter_names[] = {"sobel", "gaussian3", "gaussian5"};
+static const int num_filters = 3;
+
+// CPU version of the kernel for output rows [first, last), written
+// independently of the line buffer formulation
+static void filter_rows(
+    const uint32_t* in, uint32_t* out, int width, int height, int filter, int first, int last) {
+    static const int binomial3[3] = {1, 2, 1};
+    static const int binomial5[5] = {1, 4, 6, 4, 1};
+    int radius = filter == FILTER_GAUSSIAN5 ? 2 : 1;
+    for (int y = first; y < last; y++) {
+        for (int x = 0; x < width; x++) {
+            if (y < radius || y >= height - radius || x < radius || x >= width - radius) {
+                out[y * width + x] = in[y * width + x];
+                continue;
+            }
+            uint32_t result = 0;
+            for (int c = 0; c < 3; c++) {
+                auto p = [&](int dy, int dx) { return (int)((in[(y + dy) * width + x + dx] >> (8 * c)) & 0xff); };
+                int value = 0;
+                if (filter == FILTER_SOBEL) {
+                    int gx = 0, gy = 0;
+                    for (int k = -1; k <= 1; k++) {
+                        gx += binomial3[k + 1] * (p(k, 1) - p(k, -1));
+                        gy += binomial3[k + 1] * (p(1, k) - p(-1, k));
+                    }
+                    value = std::min(255, std::abs(gx) + std::abs(gy));
+                } else {
+                    const int* taps = filter == FILTER_GAUSSIAN5 ? binomial5 : binomial3;
+                    int shift = filter == FILTER_GAUSSIAN5 ? 8 : 4;
+                    for (int dy = -radius; dy <= radius; dy++) {
+                        for (int dx = -radius; dx <= radius; dx++) {
+                            value += taps[dy + radius] * taps[dx + radius] * p(dy, dx);
+                        }
+                    }
+                    value = (value + (1 << (shift - 1))) >> shift;
+                }
+                result |= (uint32_t)value << (8 * c);
+            }
+            out[y * width + x] = result;
+        }
+    }
+}
+
+static void filter_cpu(const uint32_t* in, uint32_t* out, int width, int height, int filter, unsigned threads) {
+    std::vector<std::thread> workers;
+    int rows = (height + threads - 1) / threads;
+    for (unsigned t = 1; t < threads && t * rows < (unsigned)height; t++) {
+        workers.emplace_back(filter_rows, in, out, width, height, filter, t * rows,
+                             std::min(height, (int)(t + 1) * rows));
+    }
+    filter_rows(in, out, width, height, filter, 0, std::min(height, rows));
+    for (auto& worker : workers) worker.join();
+}
+
+int main(int argc, char* argv[]) {
+    // Command Line Parser
+    sda::utils::CmdLineParser parser;
+
+    // Switches
+    //**************//"<Full Arg>",  "<Short Arg>", "<Description>", "<Default>"
+    parser.addSwitch("--xclbin_file", "-x", "input binary file string", "");
+    parser.addSwitch("--device_id", "-d", "device index", "0");
+    parser.addSwitch("--input", "-i", "24 or 32 bit BMP image to filter", "");
+    parser.addSwitch("--output", "-o", "prefix of the filtered images, <prefix>_<filter>.bmp", "output");
+    parser.addSwitch("--filter", "-f", "sobel, gaussian3, gaussian5 or all", "all");
+    parser.parse(argc, argv);
+
+    // Read settings
+    std::string binaryFile = parser.value("xclbin_file");
+    int device_index = stoi(parser.value("device_id"));
+    std::string inputFile = parser.value("input");
+    std::string outputPrefix = parser.value("output");
+    std::string filterName = parser.value("filter");
+
+    if (argc < 3 || inputFile.empty()) {
+        parser.printHelp();
+        return EXIT_FAILURE;
+    }
+    std::vector<int> filters;
+    for (int f = 0; f < num_filters; f++) {
+        if (filterName == "all" || filterName == filter_names[f]) filters.push_back(f);
+    }
+    if (filters.empty()) {
+        std::cout << "Unknown filter " << filterName << std::endl;
+        parser.printHelp();
+        return EXIT_FAILURE;
+    }
+
+    BitmapView image;
+    if (!image.open(inputFile.c_str())) return EXIT_FAILURE;
+    int width = image.getWidth();
+    int height = image.getHeight();
+    if (xcl::is_hw_emulation()) {
+        width = std::min(width, 128);
+        height = std::min(height, 32);
+        std::cout << "Image is cropped to " << width << "x" << height << " for faster execution on hw_emu."
+                  << std::endl;
+    }
+    if (width > MAX_WIDTH) {
+        std::cout << inputFile << " is wider than the " << MAX_WIDTH << " pixels the kernel supports" << std::endl;
+        return EXIT_FAILURE;
+    }
+    size_t pixels = (size_t)width * height;
+    double megapixels = pixels / 1e6;
+    // Whole 512 bit words, the kernel writes the last one entirely
+    size_t image_size_bytes = (pixels * sizeof(uint32_t) + 63) / 64 * 64;
+
+    std::cout << "Open the device" << device_index << std::endl;
+    auto device = xrt::device(device_index);
+    std::cout << "Load the xclbin " << binaryFile << std::endl;
+    auto uuid = device.load_xclbin(binaryFile);
+
+    auto krnl = xrt::kernel(device, uuid, "image_filter");
+
+    std::cout << "Allocate Buffer in Global Memory\n";
+    auto bo_in = xrt::bo(device, image_size_bytes, krnl.group_id(0));
+    auto bo_out = xrt::bo(device, image_size_bytes, krnl.group_id(1));
+    auto bo_in_map = bo_in.map<uint32_t*>();
+    auto bo_out_map = bo_out.map<uint32_t*>();
+
+    // Rows go straight from the file mapping into the buffer, top row first
+    // and widened to 32 bit pixels
+    for (int y = 0; y < height; y++) {
+        if (image.getBytesPerPixel() == 3)
+            xcl::rgb24_to_rgba32(bo_in_map + (size_t)y * width, image.row(y), width);
+        else
+            memcpy(bo_in_map + (size_t)y * width, image.row(y), width * sizeof(uint32_t));
+    }
+    image.close();
+    std::cout << "Input image " << inputFile << ", " << width << "x" << height << std::endl;
+    bo_in.sync(XCL_BO_SYNC_BO_TO_DEVICE);
+
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<uint32_t> reference(pixels);
+    std::vector<unsigned char> rgb(pixels * 3);
+
+    xcl::bench_options bench_opts;
+    if (xcl::is_emulation()) {
+        bench_opts.warmup = 0;
+        bench_opts.repetitions = 1;
+    }
+    xcl::benchmark bench("image_filter", bench_opts.from_env());
+
+    bool match = true;
+    for (int filter : filters) {
+        std::string name = filter_names[filter];
+        auto& kernel = bench.run(name + " kernel",
+                                 [&] {
+                                     auto run = krnl(bo_in, bo_out, width, height, filter);
+                                     run.wait();
+                                 },
+                                 megapixels, "MP/s");
+        bo_out.sync(XCL_BO_SYNC_BO_FROM_DEVICE);
+
+        auto& cpu =
+            bench.run(name + " cpu " + std::to_string(threads) + " threads",
+                      [&] { filter_cpu(bo_in_map, reference.data(), width, height, filter, threads); }, megapixels,
+                      "MP/s");
+
+        size_t mismatches = 0;
+        for (size_t i = 0; i < pixels; i++) {
+            if (bo_out_map[i] == reference[i]) continue;
+            if (mismatches++ == 0) {
+                std::cout << "Mismatch at (" << i % width << ", " << i / width << "): kernel " << std::hex
+                          << bo_out_map[i] << ", cpu " << reference[i] << std::dec << std::endl;
+            }
+        }
+        match = match && mismatches == 0;
+
+        std::string outputFile = outputPrefix + "_" + name + ".bmp";
+        xcl::rgba32_to_rgb24(rgb.data(), bo_out_map, pixels);
+        writeBitmap(outputFile.c_str(), width, height, rgb.data(), (size_t)width * 3);
+
+        std::cout << name << ": kernel " << kernel.rate() << " MP/s, cpu " << cpu.rate() << " MP/s, "
+                  << mismatches << " mismatching pixels, written to " << outputFile << std::endl;
+    }
+    bench.print_summary();
+    bench.save();
+
+    std::cout << (match ? "TEST PASSED" : "TEST FAILED") << std::endl;
+    return match ? EXIT_SUCCESS : EXIT_FAILURE;
+}
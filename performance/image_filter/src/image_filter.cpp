@@ -0,0 +1,231 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+
+/*******************************************************************************
+Description:
+    This example filters an image with a 3x3 or 5x5 convolution using the
+    load/compute/store coding style of hello_world. Pixels are 32 bit words,
+    B G R and an unused byte, so a 512 bit port carries 16 of them.
+
+    The compute function takes one pixel per clock cycle. It keeps the last
+    four image rows in line buffers and slides a 5x5 window over the image:
+    every new pixel shifts the window one column to the right and brings in
+    a new column, made of the four buffered pixels above it and the pixel
+    itself. The window therefore always holds the 5x5 neighbourhood of the
+    pixel two rows and two columns behind the input, which is the one written
+    out. The 3x3 filters use the centre of the same window.
+
+    Filters, applied to B, G and R separately:
+        0 Sobel       |Gx| + |Gy| of the 3x3 Sobel operators, clipped to 255
+        1 Gaussian3   3x3 binomial blur,   [1 2 1] x [1 2 1] / 16
+        2 Gaussian5   5x5 binomial blur, [1 4 6 4 1] x [1 4 6 4 1] / 256
+    Pixels closer to the border than the filter radius are copied unchanged.
+                                       _____________
+                                      |             |<----- Input image from Global Memory
+                                      |  read_input |       __
+                                      |_____________|----->|  | wide_in
+                                       _____________       |__|
+                                      |             |<------'
+                                      | unpack      |       __
+                                      |_____________|----->|  | pixel_in
+                                       _____________       |__|
+                                      |             |<------'
+                                      | convolve    |       __
+                                      |_____________|----->|  | pixel_out
+                                       _____________       |__|
+                                      |             |<------'
+                                      | pack        |       __
+                                      |_____________|----->|  | wide_out
+                                       ______________      |__|
+                                      |              |<-----'
+                                      | write_result |
+                                      |______________|-----> Output image to Global Memory
+
+*******************************************************************************/
+
+#include <ap_int.h>
+#include <hls_stream.h>
+#include <stdint.h>
+
+#define MAX_WIDTH 4096
+#define PIXELS_PER_WORD 16
+#define RADIUS 2 // of the 5x5 window
+#define WINDOW (2 * RADIUS + 1)
+
+#define FILTER_SOBEL 0
+#define FILTER_GAUSSIAN3 1
+#define FILTER_GAUSSIAN5 2
+
+typedef ap_uint<512> word_t;
+typedef uint32_t pixel_t;
+
+// TRIPCOUNT identifiers, a 1920x1080 image
+const int c_pixels = 1920 * 1080;
+const int c_words = c_pixels / PIXELS_PER_WORD;
+const int c_width = 1920;
+const int c_height = 1080;
+
+static void read_input(const word_t* in, hls::stream<word_t>& outStream, int words) {
+mem_rd:
+    for (int i = 0; i < words; i++) {
+#pragma HLS LOOP_TRIPCOUNT min = c_words max = c_words
+        outStream << in[i];
+    }
+}
+
+static void unpack(hls::stream<word_t>& inStream, hls::stream<pixel_t>& outStream, int pixels) {
+    word_t word;
+unpack_pixels:
+    for (int i = 0; i < pixels; i++) {
+#pragma HLS LOOP_TRIPCOUNT min = c_pixels max = c_pixels
+        int lane = i % PIXELS_PER_WORD;
+        if (lane == 0) word = inStream.read();
+        outStream << (pixel_t)word.range(32 * lane + 31, 32 * lane);
+    }
+}
+
+static uint8_t channel(pixel_t p, int c) {
+    return (p >> (8 * c)) & 0xff;
+}
+
+// Filters the neighbourhood in window, centred on window[RADIUS][RADIUS]
+static pixel_t filter_pixel(pixel_t window[WINDOW][WINDOW], int filter) {
+#pragma HLS INLINE
+    const int binomial[WINDOW] = {1, 4, 6, 4, 1};
+    const int binomial3[3] = {1, 2, 1};
+    pixel_t result = 0;
+filter_channels:
+    for (int c = 0; c < 3; c++) {
+        int gx = 0, gy = 0, blur3 = 0, blur5 = 0;
+        for (int i = 0; i < WINDOW; i++) {
+            for (int j = 0; j < WINDOW; j++) {
+                int v = channel(window[i][j], c);
+                blur5 += binomial[i] * binomial[j] * v;
+                if (i < 1 || i > 3 || j < 1 || j > 3) continue;
+                blur3 += binomial3[i - 1] * binomial3[j - 1] * v;
+                gx += (j - 2) * binomial3[i - 1] * v;
+                gy += (i - 2) * binomial3[j - 1] * v;
+            }
+        }
+        int value;
+        if (filter == FILTER_SOBEL) {
+            value = (gx < 0 ? -gx : gx) + (gy < 0 ? -gy : gy);
+            if (value > 255) value = 255;
+        } else if (filter == FILTER_GAUSSIAN3) {
+            value = (blur3 + 8) >> 4;
+        } else {
+            value = (blur5 + 128) >> 8;
+        }
+        result |= (pixel_t)value << (8 * c);
+    }
+    return result;
+}
+
+static void convolve(
+    hls::stream<pixel_t>& inStream, hls::stream<pixel_t>& outStream, int width, int height, int filter) {
+    // Rows y - 4 to y - 1 of the current column, oldest first
+    static pixel_t lineBuffer[WINDOW - 1][MAX_WIDTH];
+#pragma HLS ARRAY_PARTITION variable = lineBuffer complete dim = 1
+    pixel_t window[WINDOW][WINDOW] = {};
+#pragma HLS ARRAY_PARTITION variable = window complete dim = 0
+
+    int radius = filter == FILTER_GAUSSIAN5 ? 2 : 1;
+    // The window trails the input by RADIUS rows and columns, so run that
+    // much past the end of the image to flush the last rows and columns
+convolve_rows:
+    for (int y = 0; y < height + RADIUS; y++) {
+#pragma HLS LOOP_TRIPCOUNT min = c_height max = c_height
+    convolve_cols:
+        for (int x = 0; x < width + RADIUS; x++) {
+#pragma HLS LOOP_TRIPCOUNT min = c_width max = c_width
+#pragma HLS PIPELINE II = 1
+            bool inside = y < height && x < width;
+            pixel_t in = inside ? inStream.read() : 0;
+
+            pixel_t column[WINDOW];
+            for (int i = 0; i < WINDOW - 1; i++) column[i] = x < width ? lineBuffer[i][x] : 0;
+            column[WINDOW - 1] = in;
+            if (x < width) {
+                for (int i = 0; i < WINDOW - 2; i++) lineBuffer[i][x] = column[i + 1];
+                lineBuffer[WINDOW - 2][x] = in;
+            }
+
+            for (int i = 0; i < WINDOW; i++) {
+                for (int j = 0; j < WINDOW - 1; j++) window[i][j] = window[i][j + 1];
+                window[i][WINDOW - 1] = column[i];
+            }
+
+            int cy = y - RADIUS, cx = x - RADIUS;
+            if (cy < 0 || cx < 0) continue;
+            bool border = cy < radius || cy >= height - radius || cx < radius || cx >= width - radius;
+            pixel_t centre = window[RADIUS][RADIUS];
+            outStream << (border ? centre : filter_pixel(window, filter));
+        }
+    }
+}
+
+static void pack(hls::stream<pixel_t>& inStream, hls::stream<word_t>& outStream, int pixels) {
+    word_t word = 0;
+pack_pixels:
+    for (int i = 0; i < pixels; i++) {
+#pragma HLS LOOP_TRIPCOUNT min = c_pixels max = c_pixels
+        int lane = i % PIXELS_PER_WORD;
+        word.range(32 * lane + 31, 32 * lane) = inStream.read();
+        if (lane == PIXELS_PER_WORD - 1 || i == pixels - 1) {
+            outStream << word;
+            word = 0;
+        }
+    }
+}
+
+static void write_result(word_t* out, hls::stream<word_t>& inStream, int words) {
+mem_wr:
+    for (int i = 0; i < words; i++) {
+#pragma HLS LOOP_TRIPCOUNT min = c_words max = c_words
+        out[i] = inStream.read();
+    }
+}
+
+extern "C" {
+/*
+    Image filter kernel implementation using dataflow
+    Arguments:
+        in     (input)  --> Input image, width * height 32 bit pixels, top row first
+        out    (output) --> Output image, same layout
+        width  (input)  --> Image width in pixels, at most MAX_WIDTH
+        height (input)  --> Image height in pixels
+        filter (input)  --> FILTER_SOBEL, FILTER_GAUSSIAN3 or FILTER_GAUSSIAN5
+   */
+void image_filter(const word_t* in, word_t* out, int width, int height, int filter) {
+#pragma HLS INTERFACE m_axi port = in bundle = gmem0
+#pragma HLS INTERFACE m_axi port = out bundle = gmem1
+
+    static hls::stream<word_t> wideIn("wide_in");
+    static hls::stream<pixel_t> pixelIn("pixel_in");
+    static hls::stream<pixel_t> pixelOut("pixel_out");
+    static hls::stream<word_t> wideOut("wide_out");
+
+    int pixels = width * height;
+    int words = (pixels + PIXELS_PER_WORD - 1) / PIXELS_PER_WORD;
+
+#pragma HLS dataflow
+    read_input(in, wideIn, words);
+    unpack(wideIn, pixelIn, pixels);
+    convolve(pixelIn, pixelOut, width, height, filter);
+    pack(pixelOut, wideOut, pixels);
+    write_result(out, wideOut, words);
+}
+}
@@ -0,0 +1,245 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+
+#include "bench.h"
+#include "bo_slab.h"
+#include "cmdlineparser.h"
+#include "xcl2.hpp"
+#include "xrt_coro.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <thread>
+#include <vector>
+
+#include "experimental/xrt_bo.h"
+#include "experimental/xrt_device.h"
+#include "experimental/xrt_kernel.h"
+
+static const char hello_string[] = "Hello World\n";
+
+// One in-flight request: a prepared run of hello and its argument buffer
+struct slot {
+    xrt::run run;
+    xrt::bo bo;
+    char* map;
+};
+
+// CPU time and context switches of every thread of the process, XRT's included
+struct cpu_usage {
+    double seconds;
+    long switches;
+
+    static cpu_usage now() {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        double user = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1e-6;
+        double sys = usage.ru_stime.tv_sec + usage.ru_stime.tv_usec * 1e-6;
+        return {user + sys, usage.ru_nvcsw + usage.ru_nivcsw};
+    }
+};
+
+// Clears the string on the host, the caller then transfers it to the device
+// so that a run that writes nothing is caught
+static void clear_string(slot& s) {
+    std::fill(s.map, s.map + sizeof(hello_string), 0);
+}
+
+// Runs hello on the slot and reads its buffer back; false if the buffer does
+// not hold the kernel's string
+static bool request_blocking(slot& s) {
+    clear_string(s);
+    s.bo.sync(XCL_BO_SYNC_BO_TO_DEVICE, sizeof(hello_string), 0);
+    s.run.start();
+    s.run.wait();
+    s.bo.sync(XCL_BO_SYNC_BO_FROM_DEVICE);
+    return memcmp(s.map, hello_string, sizeof(hello_string)) == 0;
+}
+
+static xcl::task request_coroutine(xcl::completion_reactor& reactor,
+                                   slot& s,
+                                   std::vector<slot*>& free_slots,
+                                   size_t& mismatches) {
+    clear_string(s);
+    co_await reactor.sync(s.bo, XCL_BO_SYNC_BO_TO_DEVICE, sizeof(hello_string), 0);
+    s.run.start();
+    co_await reactor.wait(s.run);
+    co_await reactor.sync(s.bo, XCL_BO_SYNC_BO_FROM_DEVICE);
+    if (memcmp(s.map, hello_string, sizeof(hello_string)) != 0) mismatches++;
+    free_slots.push_back(&s);
+}
+
+// A new thread for every request, at most in_flight of them at a time
+static size_t run_threads(std::vector<slot>& slots, size_t in_flight, uint64_t num_cmds) {
+    // Shared with the detached threads, which may still be unwinding when
+    // the last completion has been counted
+    struct state {
+        std::mutex mutex;
+        std::condition_variable done;
+        std::vector<slot*> free_slots;
+        uint64_t completed = 0;
+        size_t mismatches = 0;
+    };
+    auto st = std::make_shared<state>();
+    for (size_t i = 0; i < in_flight; i++) st->free_slots.push_back(&slots[i]);
+
+    std::unique_lock<std::mutex> lock(st->mutex);
+    for (uint64_t i = 0; i < num_cmds; i++) {
+        st->done.wait(lock, [&] { return !st->free_slots.empty(); });
+        slot* s = st->free_slots.back();
+        st->free_slots.pop_back();
+        std::thread([st, s] {
+            bool match = request_blocking(*s);
+            std::lock_guard<std::mutex> guard(st->mutex);
+            if (!match) st->mismatches++;
+            st->free_slots.push_back(s);
+            st->completed++;
+            st->done.notify_all();
+        }).detach();
+    }
+    st->done.wait(lock, [&] { return st->completed == num_cmds; });
+    return st->mismatches;
+}
+
+// A coroutine for every request, all of them on this thread
+static size_t run_coroutines(xcl::completion_reactor& reactor,
+                             std::vector<slot>& slots,
+                             size_t in_flight,
+                             uint64_t num_cmds) {
+    std::vector<slot*> free_slots;
+    for (size_t i = 0; i < in_flight; i++) free_slots.push_back(&slots[i]);
+    size_t mismatches = 0;
+
+    uint64_t issued = 0;
+    while (issued < num_cmds || reactor.active() > 0) {
+        while (issued < num_cmds && !free_slots.empty()) {
+            slot* s = free_slots.back();
+            free_slots.pop_back();
+            reactor.spawn(request_coroutine(reactor, *s, free_slots, mismatches));
+            issued++;
+        }
+        reactor.run_one();
+    }
+    return mismatches;
+}
+
+int main(int argc, char* argv[]) {
+    // Command Line Parser
+    sda::utils::CmdLineParser parser;
+
+    // Switches
+    //**************//"<Full Arg>",  "<Short Arg>", "<Description>", "<Default>"
+    parser.addSwitch("--xclbin_file", "-x", "input binary file string", "");
+    parser.addSwitch("--device_id", "-d", "device index", "0");
+    parser.addSwitch("--num_cmds", "-n", "requests per measurement", "100000");
+    parser.addSwitch("--in_flight", "-k", "requests in flight to sweep, e.g. 1,8,64 or 1:256:x4", "1,4,16,64,256");
+    parser.addSwitch("--transfer_queues", "-q", "xrt::queues the reactor runs syncs on", "4");
+    parser.parse(argc, argv);
+
+    // Read settings
+    std::string binaryFile = parser.value("xclbin_file");
+    int device_index = stoi(parser.value("device_id"));
+
+    if (argc < 3) {
+        parser.printHelp();
+        return EXIT_FAILURE;
+    }
+
+    int num_cmds = parser.value_to_int("num_cmds");
+    int transfer_queues = parser.value_to_int("transfer_queues");
+    std::vector<uint64_t> in_flight = parser.value_to_sweep("in_flight");
+    if (num_cmds < 1 || transfer_queues < 1 || in_flight.empty() ||
+        std::count(in_flight.begin(), in_flight.end(), 0)) {
+        parser.printHelp();
+        return EXIT_FAILURE;
+    }
+    if (xcl::is_emulation() && !parser.isValid("num_cmds")) {
+        num_cmds = 20;
+        std::cout << "Number of requests is reduced for faster execution on emulation flow.\n";
+    }
+    size_t max_in_flight = *std::max_element(in_flight.begin(), in_flight.end());
+
+    std::cout << "Open the device" << device_index << std::endl;
+    auto device = xrt::device(device_index);
+    std::cout << "Load the xclbin " << binaryFile << std::endl;
+    auto uuid = device.load_xclbin(binaryFile);
+    auto hello = xrt::kernel(device, uuid.get(), "hello");
+
+    // Argument buffers come from one slab, as in iops_test_xrt
+    xcl::bo_slab slab(device, hello.group_id(0), 20, max_in_flight);
+    std::vector<slot> slots(max_in_flight);
+    for (auto& s : slots) {
+        s.bo = slab.alloc();
+        s.map = s.bo.map<char*>();
+        std::fill(s.map, s.map + 20, 0);
+        s.bo.sync(XCL_BO_SYNC_BO_TO_DEVICE);
+        s.run = xrt::run(hello);
+        s.run.set_arg(0, s.bo);
+    }
+
+    xcl::completion_reactor reactor(transfer_queues);
+
+    xcl::bench_options bench_opts;
+    if (xcl::is_emulation()) {
+        bench_opts.warmup = 0;
+        bench_opts.repetitions = 1;
+    } else {
+        bench_opts.repetitions = 3;
+    }
+    xcl::benchmark bench("iops_coroutine_xrt", bench_opts.from_env());
+
+    bool match = true;
+    printf("%-10s %9s %12s %12s %12s %12s\n", "Mode", "InFlight", "ops/s", "CPU(cores)", "CPU(us/op)", "ctxsw/op");
+    for (auto k : in_flight) {
+        for (int mode = 0; mode < 2; mode++) {
+            std::string name = mode == 0 ? "threads" : "coroutine";
+            size_t mismatches = 0;
+            cpu_usage cpu_start = {0, 0}, cpu_end = {0, 0};
+            auto& result = bench.run(name + " " + std::to_string(k) + " in flight",
+                                     [&] {
+                                         cpu_start = cpu_usage::now();
+                                         if (mode == 0)
+                                             mismatches += run_threads(slots, k, num_cmds);
+                                         else
+                                             mismatches += run_coroutines(reactor, slots, k, num_cmds);
+                                         cpu_end = cpu_usage::now();
+                                     },
+                                     num_cmds, "ops/s");
+            if (mismatches) {
+                printf("%s, %d in flight: %zu buffers do not hold the kernel's string\n", name.c_str(), (int)k,
+                       mismatches);
+                match = false;
+            }
+            // CPU figures are from the last measured pass
+            double cpu_seconds = cpu_end.seconds - cpu_start.seconds;
+            double wall = result.seconds.empty() ? 0 : result.seconds.back();
+            printf("%-10s %9d %12.0f %12.2f %12.2f %12.2f\n", name.c_str(), (int)k, result.rate(),
+                   wall > 0 ? cpu_seconds / wall : 0, cpu_seconds * 1e6 / num_cmds,
+                   (double)(cpu_end.switches - cpu_start.switches) / num_cmds);
+        }
+    }
+    bench.save();
+
+    for (auto& s : slots) slab.free(s.bo);
+    std::cout << (match ? "TEST PASSED" : "TEST FAILED") << std::endl;
+    return match ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -14,7 +14,10 @@
 * under the License.
 */
 
+#include "bench.h"
+#include "bo_slab.h"
 #include "cmdlineparser.h"
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <vector>
@@ -33,6 +36,8 @@ int main(int argc, char* argv[]) {
     //**************//"<Full Arg>",  "<Short Arg>", "<Description>", "<Default>"
     parser.addSwitch("--xclbin_file", "-x", "input binary file string", "");
     parser.addSwitch("--device_id", "-d", "device index", "0");
+    parser.addSwitch("--num_cmds", "-n", "command counts to sweep, e.g. 10,100,1000 or 1K:1M:x10",
+                     "10,50,100,200,500,1000,1500,2000,3000,5000,10000,50000,100000,500000,1000000");
     parser.parse(argc, argv);
 
     // Read settings
@@ -50,57 +55,87 @@ int main(int argc, char* argv[]) {
     auto uuid = device.load_xclbin(binaryFile);
 
     /* The command would incease */
-    std::vector<unsigned int> cmds_per_run = {10,   50,   100,   200,   500,    1000,   1500,   2000,
-                                              3000, 5000, 10000, 50000, 100000, 500000, 1000000};
-    int expected_cmds = 10000;
+    std::vector<uint64_t> cmds_per_run = parser.value_to_sweep("num_cmds");
+    if (cmds_per_run.empty() || std::count(cmds_per_run.begin(), cmds_per_run.end(), 0)) {
+        parser.printHelp();
+        return EXIT_FAILURE;
+    }
 
-    if (xcl::is_emulation()) {
+    if (xcl::is_emulation() && !parser.isValid("num_cmds")) {
         cmds_per_run = {10, 20};
         std::cout << "Number of operations is reduced for faster execution on "
                      "emulation flow.\n";
-        expected_cmds = 20;
     }
+    // Up to 10000 commands are kept in flight, never more than the largest run needs
+    int expected_cmds = std::min<uint64_t>(10000, *std::max_element(cmds_per_run.begin(), cmds_per_run.end()));
     auto hello = xrt::kernel(device, uuid.get(), "hello");
 
+    /* Allocation latency: one xrt::bo per command against sub-buffers of a slab */
+    std::vector<xrt::bo> bos;
+    bos.reserve(expected_cmds);
+    auto alloc_start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < expected_cmds; i++) bos.push_back(xrt::bo(device, 20, hello.group_id(0)));
+    auto alloc_end = std::chrono::high_resolution_clock::now();
+    double bo_us = std::chrono::duration<double, std::micro>(alloc_end - alloc_start).count();
+    bos.clear();
+
+    alloc_start = std::chrono::high_resolution_clock::now();
+    xcl::bo_slab slab(device, hello.group_id(0), 20, expected_cmds);
+    for (int i = 0; i < expected_cmds; i++) bos.push_back(slab.alloc());
+    alloc_end = std::chrono::high_resolution_clock::now();
+    double slab_us = std::chrono::duration<double, std::micro>(alloc_end - alloc_start).count();
+
+    std::cout << "Allocation of " << expected_cmds << " buffers, per-BO: " << bo_us / expected_cmds
+              << " us/buffer, slab: " << slab_us / expected_cmds << " us/buffer (including slab creation)"
+              << std::endl;
+
     /* Create 'expected_cmds' commands if possible */
     std::vector<xrt::run> cmds;
-    std::vector<xrt::bo> bos;
-    for (int i = 0; i < expected_cmds; i++) {
+    for (auto& bo : bos) {
         auto run = xrt::run(hello);
-        auto bo = xrt::bo(device, 20, hello.group_id(0));
         run.set_arg(0, bo);
         cmds.push_back(std::move(run));
-        bos.push_back(std::move(bo));
     }
     std::cout << "Allocated commands, expect " << expected_cmds << ", created " << cmds.size() << std::endl;
 
+    xcl::bench_options bench_opts;
+    if (xcl::is_emulation()) {
+        bench_opts.warmup = 0;
+        bench_opts.repetitions = 1;
+    } else {
+        bench_opts.repetitions = 3;
+    }
+    xcl::benchmark bench("iops_test_xrt", bench_opts.from_env());
+
     for (auto num_cmds : cmds_per_run) {
-        uint32_t i = 0;
-        unsigned int issued = 0, completed = 0;
-        auto start = std::chrono::high_resolution_clock::now();
-
-        for (auto& cmd : cmds) {
-            cmd.start();
-            if (++issued == num_cmds) break;
-        }
-
-        while (completed < num_cmds) {
-            cmds[i].wait();
-
-            completed++;
-            if (issued < num_cmds) {
-                cmds[i].start();
-                issued++;
-            }
-
-            if (++i == cmds.size()) i = 0;
-        }
-
-        auto end = std::chrono::high_resolution_clock::now();
-        double duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-        std::cout << "Commands: " << std::setw(7) << num_cmds << " iops: " << (num_cmds * 1000.0 * 1000.0 / duration)
-                  << std::endl;
+        auto& result = bench.run("commands " + std::to_string(num_cmds),
+                                 [&] {
+                                     uint32_t i = 0;
+                                     unsigned int issued = 0, completed = 0;
+
+                                     for (auto& cmd : cmds) {
+                                         cmd.start();
+                                         if (++issued == num_cmds) break;
+                                     }
+
+                                     while (completed < num_cmds) {
+                                         cmds[i].wait();
+
+                                         completed++;
+                                         if (issued < num_cmds) {
+                                             cmds[i].start();
+                                             issued++;
+                                         }
+
+                                         if (++i == cmds.size()) i = 0;
+                                     }
+                                 },
+                                 num_cmds, "ops/s");
+        std::cout << "Commands: " << std::setw(7) << num_cmds << " iops: " << result.rate() << std::endl;
     }
+    bench.save();
+    cmds.clear();
+    for (auto& bo : bos) slab.free(bo);
     std::cout << "TEST PASSED\n";
     return 0;
 }
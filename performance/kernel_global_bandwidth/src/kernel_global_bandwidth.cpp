@@ -50,6 +50,7 @@
 *
 *********************************************************************************************/
 
+#include "fastmem.h"
 #include "xcl2.hpp"
 #include <stdint.h>
 #include <stdio.h>
@@ -119,9 +120,7 @@ int main(int argc, char** argv) {
         return EXIT_FAILURE;
     }
 
-    for (size_t i = 0; i < globalbuffersize; i++) {
-        input_host[i] = i % 256;
-    }
+    xcl::fast_fill_ramp(input_host, globalbuffersize);
 
     short ddr_banks = NDDR_BANKS;
 
@@ -187,9 +186,7 @@ int main(int argc, char** argv) {
     OCL_CHECK(err, err = q.finish());
 
     /* prepare data to be written to the device */
-    for (size_t i = 0; i < globalbuffersize; i++) {
-        map_input_buffer0[i] = input_host[i];
-    }
+    xcl::fast_copy(map_input_buffer0, input_host, globalbuffersize);
     OCL_CHECK(err, err = q.enqueueUnmapMemObject(*(buffer[0]), map_input_buffer0));
 
     OCL_CHECK(err, err = q.finish());
@@ -202,9 +199,7 @@ int main(int argc, char** argv) {
     OCL_CHECK(err, err = q.finish());
 
     /* Prepare data to be written to the device */
-    for (size_t i = 0; i < globalbuffersize; i++) {
-        map_input_buffer1[i] = input_host[i];
-    }
+    xcl::fast_copy(map_input_buffer1, input_host, globalbuffersize);
 
     OCL_CHECK(err, err = q.enqueueUnmapMemObject(*(buffer[2]), map_input_buffer1));
     OCL_CHECK(err, err = q.finish());
@@ -14,6 +14,7 @@
 * under the License.
 */
 #include "cmdlineparser.h"
+#include "perf_counters.h"
 #include "xcl2.hpp"
 #include <iomanip>
 #include <iostream>
@@ -39,6 +40,7 @@ int main(int argc, char* argv[]) {
     parser.addSwitch("--xclbin_file2", "-x2", "input binary file2 string", "");
     parser.addSwitch("--device0", "-d0", "first device id", "0");
     parser.addSwitch("--device1", "-d1", "second device id", "1");
+    parser.addSwitch("--perf_events", "-p", "report host perf_event counters of each transfer", "", true);
     parser.parse(argc, argv);
 
     // Read settings
@@ -213,6 +215,12 @@ int main(int argc, char* argv[]) {
     OCL_CHECK(err, err = xcl::P2P::getMemObjectFromFd(context[0], device[0], 0, fd1, &pbo2_imported)); // Import
 
     size_t max_size = 128 * 1024 * 1024; // 128MB size
+    xcl::perf_counters counters(parser.value_to_bool("perf_events"));
+    // Host side counters of the last timed region, as a line to print after the bandwidth numbers
+    auto host_counters = [&counters](const char* region) {
+        return counters.available() ? "    Host during " + std::string(region) + ": " + counters.summary() + "\n"
+                                    : std::string();
+    };
     std::cout << "Start P2P copy of various Buffer sizes \n";
     for (size_t bufsize = min_buffer; bufsize <= vector_size_bytes; bufsize *= 2) {
         std::string size_str = xcl::convert_size(bufsize);
@@ -223,8 +231,10 @@ int main(int argc, char* argv[]) {
         double dnsduration, dsduration, gbpersec;
         std::chrono::high_resolution_clock::time_point p2pReadWriteStart, p2pReadWriteEnd;
         cl_ulong p2pReadWriteTime;
+        std::string host_report;
         if (!dev0_nodma_chk) {
             //////////////////////// DMA Write by FPGA-1 //////////////////////////
+            counters.start();
             std::chrono::high_resolution_clock::time_point p2pReadStart = std::chrono::high_resolution_clock::now();
             for (int j = 0; j < iter; j++) {
                 OCL_CHECK(err, err = clEnqueueCopyBuffer(queue[0], rbo1, pbo2_imported, 0, 0, bufsize, 0, nullptr,
@@ -232,6 +242,7 @@ int main(int argc, char* argv[]) {
             }
             clFinish(queue[0]);
             std::chrono::high_resolution_clock::time_point p2pReadEnd = std::chrono::high_resolution_clock::now();
+            counters.stop();
             cl_ulong p2pReadTime =
                 std::chrono::duration_cast<std::chrono::microseconds>(p2pReadEnd - p2pReadStart).count();
             ;
@@ -241,8 +252,10 @@ int main(int argc, char* argv[]) {
             std::cout << "Buffer = " << size_str << " Iterations = " << iter
                       << " Total Data Transfer = " << xcl::convert_size(max_size)
                       << "\nDevice0 : DMA Write = " << std::setprecision(2) << std::fixed << gbpersec << "GB/s";
+            host_report = host_counters("DMA Write");
 
             //////////////////////// DMA Read by FPGA-1 //////////////////////////
+            counters.start();
             p2pReadStart = std::chrono::high_resolution_clock::now();
             for (int j = 0; j < iter; j++) {
                 OCL_CHECK(err, err = clEnqueueCopyBuffer(queue[0], pbo2_imported, rbo1, 0, 0, bufsize, 0, nullptr,
@@ -250,14 +263,17 @@ int main(int argc, char* argv[]) {
             }
             clFinish(queue[0]);
             p2pReadEnd = std::chrono::high_resolution_clock::now();
+            counters.stop();
             p2pReadTime = std::chrono::duration_cast<std::chrono::microseconds>(p2pReadEnd - p2pReadStart).count();
             ;
             dnsduration = (double)p2pReadTime;
             dsduration = dnsduration / ((double)1000000);
             gbpersec = ((iter * bufsize) / dsduration) / ((double)1024 * 1024 * 1024);
             std::cout << " DMA Read = " << std::setprecision(2) << std::fixed << gbpersec << "GB/s";
+            host_report += host_counters("DMA Read");
 
             //////////////////////// FPGA1 Read Write throughput /////////////////
+            counters.start();
             p2pReadWriteStart = std::chrono::high_resolution_clock::now();
             for (int j = 0; j < iter; j++) {
                 OCL_CHECK(err, err = clEnqueueCopyBuffer(queue[0], rbo1, pbo2_imported, 0, 0, bufsize, 0, nullptr,
@@ -268,6 +284,7 @@ int main(int argc, char* argv[]) {
             clFinish(queue[0]);
 
             p2pReadWriteEnd = std::chrono::high_resolution_clock::now();
+            counters.stop();
             p2pReadWriteTime =
                 std::chrono::duration_cast<std::chrono::microseconds>(p2pReadWriteEnd - p2pReadWriteStart).count();
             ;
@@ -275,9 +292,11 @@ int main(int argc, char* argv[]) {
             dsduration = dnsduration / ((double)1000000);
             gbpersec = ((2 * iter * bufsize) / dsduration) / ((double)1024 * 1024 * 1024);
             std::cout << " DMA Read Write = " << std::setprecision(2) << std::fixed << gbpersec << "GB/s\n";
+            std::cout << host_report + host_counters("DMA Read Write");
         }
         if (!dev1_nodma_chk) {
             //////////////////////// DMA Write by FPGA-2 //////////////////////////
+            counters.start();
             std::chrono::high_resolution_clock::time_point p2pWriteStart = std::chrono::high_resolution_clock::now();
             for (int j = 0; j < iter; j++) {
                 OCL_CHECK(err, err = clEnqueueCopyBuffer(queue[1], rbo2, pbo1_imported, 0, 0, bufsize, 0, nullptr,
@@ -285,14 +304,17 @@ int main(int argc, char* argv[]) {
             }
             clFinish(queue[1]);
             std::chrono::high_resolution_clock::time_point p2pWriteEnd = std::chrono::high_resolution_clock::now();
+            counters.stop();
             cl_ulong p2pWriteTime =
                 std::chrono::duration_cast<std::chrono::microseconds>(p2pWriteEnd - p2pWriteStart).count();
             dnsduration = (double)p2pWriteTime;
             dsduration = dnsduration / ((double)1000000);
             gbpersec = ((iter * bufsize) / dsduration) / ((double)1024 * 1024 * 1024);
             std::cout << "Device1 : DMA Write = " << std::setprecision(2) << std::fixed << gbpersec << "GB/s";
+            host_report = host_counters("DMA Write");
 
             //////////////////////// DMA Read by FPGA-2 //////////////////////////
+            counters.start();
             p2pWriteStart = std::chrono::high_resolution_clock::now();
             for (int j = 0; j < iter; j++) {
                 OCL_CHECK(err, err = clEnqueueCopyBuffer(queue[1], pbo1_imported, rbo2, 0, 0, bufsize, 0, nullptr,
@@ -300,13 +322,16 @@ int main(int argc, char* argv[]) {
             }
             clFinish(queue[1]);
             p2pWriteEnd = std::chrono::high_resolution_clock::now();
+            counters.stop();
             p2pWriteTime = std::chrono::duration_cast<std::chrono::microseconds>(p2pWriteEnd - p2pWriteStart).count();
             dnsduration = (double)p2pWriteTime;
             dsduration = dnsduration / ((double)1000000);
             gbpersec = ((iter * bufsize) / dsduration) / ((double)1024 * 1024 * 1024);
             std::cout << " DMA Read = " << std::setprecision(2) << std::fixed << gbpersec << "GB/s";
+            host_report += host_counters("DMA Read");
 
             //////////////////////// FPGA2 Read Write throughput /////////////////
+            counters.start();
             p2pReadWriteStart = std::chrono::high_resolution_clock::now();
             for (int j = 0; j < iter; j++) {
                 OCL_CHECK(err, err = clEnqueueCopyBuffer(queue[1], rbo2, pbo1_imported, 0, 0, bufsize, 0, nullptr,
@@ -316,13 +341,15 @@ int main(int argc, char* argv[]) {
             }
             clFinish(queue[1]);
             p2pReadWriteEnd = std::chrono::high_resolution_clock::now();
+            counters.stop();
             p2pReadWriteTime =
                 std::chrono::duration_cast<std::chrono::microseconds>(p2pReadWriteEnd - p2pReadWriteStart).count();
             ;
             dnsduration = (double)p2pReadWriteTime;
             dsduration = dnsduration / ((double)1000000);
             gbpersec = ((2 * iter * bufsize) / dsduration) / ((double)1024 * 1024 * 1024);
-            std::cout << " DMA Read Write = " << std::setprecision(2) << std::fixed << gbpersec << "GB/s\n\n";
+            std::cout << " DMA Read Write = " << std::setprecision(2) << std::fixed << gbpersec << "GB/s\n";
+            std::cout << host_report + host_counters("DMA Read Write") << "\n";
         }
     }
 
@@ -0,0 +1,246 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+
+
+#include "bench.h"
+#include "cmdlineparser.h"
+#include "fastmem.h"
+#include "lane_pack.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "xcl2.hpp"
+
+// XRT includes
+#include "experimental/xrt_bo.h"
+#include "experimental/xrt_device.h"
+#include "experimental/xrt_kernel.h"
+
+#define DATA_SIZE 4096
+
+// Element types built into the xclbin as vadd_<name>, see src/vadd_types.cpp
+static const char* type_names[] = {"int8", "int16", "int32", "float", "half"};
+static const size_t type_bytes[] = {sizeof(int8_t), sizeof(int16_t), sizeof(int32_t), sizeof(float),
+                                    sizeof(xcl::half_t)};
+static const int num_types = 5;
+
+// Input and output buffers shared by every kernel, sized for the largest run
+struct buffers {
+    xrt::bo in1, in2, out;
+    void *in1_map, *in2_map, *out_map;
+};
+
+// Integers cover the whole range of T and are added as int64_t, so sums only
+// wrap when they are packed back into T, as they do in the kernel
+template <typename T>
+static typename std::enable_if<std::is_integral<T>::value, std::vector<int64_t> >::type random_values(
+    size_t count, std::mt19937& rng) {
+    std::uniform_int_distribution<int64_t> dist(std::numeric_limits<T>::min(), std::numeric_limits<T>::max());
+    std::vector<int64_t> values(count);
+    for (auto& v : values) v = dist(rng);
+    return values;
+}
+
+// Multiples of 1/8 below 128 in magnitude: their sums need at most 11
+// significant bits, so they are exact in float and in half alike and the
+// check does not depend on how the kernel rounds
+template <typename T>
+static typename std::enable_if<!std::is_integral<T>::value, std::vector<float> >::type random_values(
+    size_t count, std::mt19937& rng) {
+    std::uniform_int_distribution<int> dist(-1023, 1023);
+    std::vector<float> values(count);
+    for (auto& v : values) v = dist(rng) / 8.0f;
+    return values;
+}
+
+// Runs the kernel of T on sizes that do not fill the last beat and compares
+// every lane it wrote, the zero padding included, with the host sums packed
+// the same way
+template <typename T>
+static bool check_kernel(const char* name, xrt::kernel& krnl, buffers& bufs, const std::vector<int>& sizes) {
+    std::mt19937 rng(1);
+    for (int size : sizes) {
+        auto in1 = random_values<T>(size, rng);
+        auto in2 = random_values<T>(size, rng);
+        auto sum = in1;
+        for (int i = 0; i < size; i++) sum[i] += in2[i];
+
+        std::vector<T> expected(xcl::padded_lanes<T>(size));
+        size_t padded = xcl::pack_lanes(expected.data(), sum.data(), size);
+        xcl::pack_lanes(static_cast<T*>(bufs.in1_map), in1.data(), size);
+        xcl::pack_lanes(static_cast<T*>(bufs.in2_map), in2.data(), size);
+        // Padding lanes must come back as zero even when the inputs hold
+        // something else there, and the output starts out as something else
+        memset(static_cast<T*>(bufs.in1_map) + size, 0xff, (padded - size) * sizeof(T));
+        memset(static_cast<T*>(bufs.in2_map) + size, 0xff, (padded - size) * sizeof(T));
+        memset(bufs.out_map, 0xff, padded * sizeof(T));
+
+        size_t bytes = padded * sizeof(T);
+        bufs.in1.sync(XCL_BO_SYNC_BO_TO_DEVICE, bytes, 0);
+        bufs.in2.sync(XCL_BO_SYNC_BO_TO_DEVICE, bytes, 0);
+        bufs.out.sync(XCL_BO_SYNC_BO_TO_DEVICE, bytes, 0);
+        auto run = krnl(bufs.in1, bufs.in2, bufs.out, size);
+        run.wait();
+        bufs.out.sync(XCL_BO_SYNC_BO_FROM_DEVICE, bytes, 0);
+
+        if (memcmp(bufs.out_map, expected.data(), bytes) == 0) continue;
+        decltype(sum) got(padded), want(padded);
+        xcl::unpack_lanes(got.data(), static_cast<const T*>(bufs.out_map), padded);
+        xcl::unpack_lanes(want.data(), expected.data(), padded);
+        size_t i = std::mismatch(got.begin(), got.end(), want.begin()).first - got.begin();
+        std::cout << "vadd_" << name << ", size " << size << ": element " << i << " is " << got[i] << ", expected "
+                  << want[i] << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    // Command Line Parser
+    sda::utils::CmdLineParser parser;
+
+    // Switches
+    //**************//"<Full Arg>",  "<Short Arg>", "<Description>", "<Default>"
+    parser.addSwitch("--xclbin_file", "-x", "input binary file string", "");
+    parser.addSwitch("--device_id", "-d", "device index", "0");
+    parser.addSwitch("--size", "-s", "vector sizes in bytes to sweep, e.g. 64K:256M:x4", "64K:256M:x4");
+    parser.addSwitch("--types", "-t", "element types to sweep, any of int8,int16,int32,float,half",
+                     "int8,int16,int32,float,half");
+    parser.parse(argc, argv);
+
+    // Read settings
+    std::string binaryFile = parser.value("xclbin_file");
+    int device_index = stoi(parser.value("device_id"));
+
+    if (argc < 3) {
+        parser.printHelp();
+        return EXIT_FAILURE;
+    }
+
+    std::vector<uint64_t> sizes = parser.value_to_sweep("size");
+    std::vector<int> types;
+    std::istringstream typeList(parser.value("types"));
+    for (std::string name; std::getline(typeList, name, ',');) {
+        int t = std::find(type_names, type_names + num_types, name) - type_names;
+        if (t == num_types) {
+            std::cout << "Unknown element type " << name << std::endl;
+            parser.printHelp();
+            return EXIT_FAILURE;
+        }
+        types.push_back(t);
+    }
+    if (sizes.empty() || types.empty() || std::count(sizes.begin(), sizes.end(), 0)) {
+        parser.printHelp();
+        return EXIT_FAILURE;
+    }
+    if (xcl::is_emulation() && !parser.isValid("size")) {
+        sizes = {16 * 1024};
+        std::cout << "Vector size is reduced for faster execution on emulation flow.\n";
+    }
+
+    // Element counts that leave the last beat partly empty for every type
+    std::vector<int> check_sizes = {1, 15, 17, 33, 65, DATA_SIZE - 1, DATA_SIZE + 3};
+
+    // Every kernel moves whole 64 byte beats, so the buffers are rounded up to one
+    size_t check_bytes = xcl::padded_lanes<int32_t>(*std::max_element(check_sizes.begin(), check_sizes.end())) * 4;
+    size_t buffer_bytes = std::max<size_t>(*std::max_element(sizes.begin(), sizes.end()), check_bytes);
+    buffer_bytes = (buffer_bytes + xcl::beat_bytes - 1) / xcl::beat_bytes * xcl::beat_bytes;
+
+    std::cout << "Open the device" << device_index << std::endl;
+    auto device = xrt::device(device_index);
+    std::cout << "Load the xclbin " << binaryFile << std::endl;
+    auto uuid = device.load_xclbin(binaryFile);
+
+    std::vector<xrt::kernel> krnls;
+    for (const char* name : type_names) krnls.push_back(xrt::kernel(device, uuid, std::string("vadd_") + name));
+
+    std::cout << "Allocate Buffer in Global Memory\n";
+    buffers bufs;
+    bufs.in1 = xrt::bo(device, buffer_bytes, krnls[0].group_id(0));
+    bufs.in2 = xrt::bo(device, buffer_bytes, krnls[0].group_id(1));
+    bufs.out = xrt::bo(device, buffer_bytes, krnls[0].group_id(2));
+    bufs.in1_map = bufs.in1.map<void*>();
+    bufs.in2_map = bufs.in2.map<void*>();
+    bufs.out_map = bufs.out.map<void*>();
+
+    std::cout << "Half conversions use the " << xcl::half_convert_isa() << " path" << std::endl;
+    bool match = check_kernel<int8_t>("int8", krnls[0], bufs, check_sizes) &&
+                 check_kernel<int16_t>("int16", krnls[1], bufs, check_sizes) &&
+                 check_kernel<int32_t>("int32", krnls[2], bufs, check_sizes) &&
+                 check_kernel<float>("float", krnls[3], bufs, check_sizes) &&
+                 check_kernel<xcl::half_t>("half", krnls[4], bufs, check_sizes);
+    if (!match) {
+        std::cout << "TEST FAILED\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << "Every element type matches the host on " << check_sizes.size()
+              << " sizes that do not fill the last beat" << std::endl;
+
+    // The sweep only measures bandwidth, any bytes will do as input
+    xcl::fast_fill_ramp(bufs.in1_map, buffer_bytes);
+    xcl::fast_fill_ramp(bufs.in2_map, buffer_bytes);
+    std::cout << "synchronize input buffer data to device global memory\n";
+    bufs.in1.sync(XCL_BO_SYNC_BO_TO_DEVICE);
+    bufs.in2.sync(XCL_BO_SYNC_BO_TO_DEVICE);
+
+    xcl::bench_options bench_opts;
+    if (xcl::is_emulation()) {
+        bench_opts.warmup = 0;
+        bench_opts.repetitions = 1;
+    }
+    xcl::benchmark bench("vadd_types", bench_opts.from_env());
+
+    // One row per size, one column of billions of elements per second per type
+    std::vector<double> rates(num_types);
+    printf("%12s", "Size");
+    for (int t : types) printf(" %9s", type_names[t]);
+    printf("\n");
+    for (uint64_t bytes : sizes) {
+        printf("%10lluKB", (unsigned long long)bytes / 1024);
+        for (int t : types) {
+            int size = bytes / type_bytes[t];
+            auto& k = krnls[t];
+            auto& result = bench.run(std::string(type_names[t]) + " " + std::to_string(bytes) + " bytes",
+                                     [&] {
+                                         auto run = k(bufs.in1, bufs.in2, bufs.out, size);
+                                         run.wait();
+                                     },
+                                     size / 1e9, "Gelem/s");
+            rates[t] = result.rate();
+            printf(" %9.3f", rates[t]);
+            fflush(stdout);
+        }
+        printf(" Gelem/s\n");
+    }
+
+    // Every type moves the same bytes, so the element rate should grow as the type narrows
+    if (std::count(types.begin(), types.end(), 2)) {
+        std::cout << "Elements per second relative to int32 at " << sizes.back() / 1024 << "KB:";
+        for (int t : types) printf(" %s %.2fx", type_names[t], rates[t] / rates[2]);
+        printf("\n");
+    }
+    bench.save();
+
+    std::cout << "TEST PASSED\n";
+    return 0;
+}
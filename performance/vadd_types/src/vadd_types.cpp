@@ -0,0 +1,189 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+
+
+/*******************************************************************************
+Description:
+    Vector addition over any element type that fits a 512 bit port. The
+    hello_world vadd adds unsigned ints one per clock cycle; here the load,
+    compute and store functions work on whole 512 bit beats,
+    hls::vector<T, 64 / sizeof(T)>, so every clock cycle adds 64 int8_t,
+    32 int16_t or half, or 16 int32_t or float values. Narrow types move
+    proportionally more elements through the same port.
+
+    T is a template parameter. The kernels vadd_int8, vadd_int16,
+    vadd_int32, vadd_float and vadd_half instantiate it, so the host can
+    compare them in one xclbin. Integer sums wrap around in the width of T.
+
+    size is in elements and does not have to fill the last beat. The kernel
+    moves whole beats, so the buffers must hold a whole number of them, and
+    it writes zero to the lanes of the last output beat that are past size.
+                                       _____________
+                                      |             |<----- Input Vector 1 from Global Memory
+                                      |  load_input |       __
+                                      |_____________|----->|  |
+                                       _____________       |  | in1_stream
+Input Vector 2 from Global Memory --->|             |      |__|
+                               __     |  load_input |        |
+                              |  |<---|_____________|        |
+                   in2_stream |  |     _____________         |
+                              |__|--->|             |<--------
+                                      | compute_add |      __
+                                      |_____________|---->|  |
+                                       ______________     |  | out_stream
+                                      |              |<---|__|
+                                      | store_result |
+                                      |______________|-----> Output result to Global Memory
+
+*******************************************************************************/
+
+#include <stdint.h>
+#include <hls_half.h>
+#include <hls_stream.h>
+#include <hls_vector.h>
+
+#define DATA_SIZE 4096
+#define BEAT_BYTES 64
+
+// TRIPCOUNT identifiers, in beats of int8_t and of 32 bit elements
+const int c_min_beats = DATA_SIZE / 64;
+const int c_max_beats = DATA_SIZE / 16;
+
+template <typename T>
+struct beat {
+    static_assert(BEAT_BYTES % sizeof(T) == 0, "a beat must hold a whole number of elements");
+    static const int lanes = BEAT_BYTES / sizeof(T);
+    typedef hls::vector<T, lanes> vec_t;
+};
+
+template <typename T>
+static void read_input(const typename beat<T>::vec_t* in, hls::stream<typename beat<T>::vec_t>& inStream, int beats) {
+// Auto-pipeline is going to apply pipeline to this loop
+mem_rd:
+    for (int i = 0; i < beats; i++) {
+#pragma HLS LOOP_TRIPCOUNT min = c_min_beats max = c_max_beats
+        inStream << in[i];
+    }
+}
+
+template <typename T>
+static void compute_add(hls::stream<typename beat<T>::vec_t>& inStream1,
+                        hls::stream<typename beat<T>::vec_t>& inStream2,
+                        hls::stream<typename beat<T>::vec_t>& outStream,
+                        int beats,
+                        int size) {
+// Auto-pipeline is going to apply pipeline to this loop
+execute:
+    for (int i = 0; i < beats; i++) {
+#pragma HLS LOOP_TRIPCOUNT min = c_min_beats max = c_max_beats
+        typename beat<T>::vec_t sum = inStream1.read() + inStream2.read();
+    // Lanes past size only exist in the last beat, they are padding
+    tail:
+        for (int l = 0; l < beat<T>::lanes; l++) {
+#pragma HLS UNROLL
+            if (i * beat<T>::lanes + l >= size) sum[l] = 0;
+        }
+        outStream << sum;
+    }
+}
+
+template <typename T>
+static void write_result(typename beat<T>::vec_t* out, hls::stream<typename beat<T>::vec_t>& outStream, int beats) {
+// Auto-pipeline is going to apply pipeline to this loop
+mem_wr:
+    for (int i = 0; i < beats; i++) {
+#pragma HLS LOOP_TRIPCOUNT min = c_min_beats max = c_max_beats
+        out[i] = outStream.read();
+    }
+}
+
+template <typename T>
+static void vadd_beats(const typename beat<T>::vec_t* in1,
+                       const typename beat<T>::vec_t* in2,
+                       typename beat<T>::vec_t* out,
+                       int size) {
+    hls::stream<typename beat<T>::vec_t> inStream1("input_stream_1");
+    hls::stream<typename beat<T>::vec_t> inStream2("input_stream_2");
+    hls::stream<typename beat<T>::vec_t> outStream("output_stream");
+    int beats = (size + beat<T>::lanes - 1) / beat<T>::lanes;
+
+#pragma HLS dataflow
+    // dataflow pragma instruct compiler to run following three APIs in parallel
+    read_input<T>(in1, inStream1, beats);
+    read_input<T>(in2, inStream2, beats);
+    compute_add<T>(inStream1, inStream2, outStream, beats, size);
+    write_result<T>(out, outStream, beats);
+}
+
+extern "C" {
+/*
+    Vector Addition Kernels, one 512 bit beat of T per clock cycle
+    Arguments:
+        in1   (input)  --> Input Vector 1
+        in2   (input)  --> Input Vector 2
+        out  (output) --> Output Vector
+        size (input)  --> Size of Vector in elements of T
+   */
+void vadd_int8(const hls::vector<int8_t, 64>* in1,
+               const hls::vector<int8_t, 64>* in2,
+               hls::vector<int8_t, 64>* out,
+               int size) {
+#pragma HLS INTERFACE m_axi port = in1 bundle = gmem0
+#pragma HLS INTERFACE m_axi port = in2 bundle = gmem1
+#pragma HLS INTERFACE m_axi port = out bundle = gmem0
+    vadd_beats<int8_t>(in1, in2, out, size);
+}
+
+void vadd_int16(const hls::vector<int16_t, 32>* in1,
+                const hls::vector<int16_t, 32>* in2,
+                hls::vector<int16_t, 32>* out,
+                int size) {
+#pragma HLS INTERFACE m_axi port = in1 bundle = gmem0
+#pragma HLS INTERFACE m_axi port = in2 bundle = gmem1
+#pragma HLS INTERFACE m_axi port = out bundle = gmem0
+    vadd_beats<int16_t>(in1, in2, out, size);
+}
+
+void vadd_int32(const hls::vector<int32_t, 16>* in1,
+                const hls::vector<int32_t, 16>* in2,
+                hls::vector<int32_t, 16>* out,
+                int size) {
+#pragma HLS INTERFACE m_axi port = in1 bundle = gmem0
+#pragma HLS INTERFACE m_axi port = in2 bundle = gmem1
+#pragma HLS INTERFACE m_axi port = out bundle = gmem0
+    vadd_beats<int32_t>(in1, in2, out, size);
+}
+
+void vadd_float(const hls::vector<float, 16>* in1,
+                const hls::vector<float, 16>* in2,
+                hls::vector<float, 16>* out,
+                int size) {
+#pragma HLS INTERFACE m_axi port = in1 bundle = gmem0
+#pragma HLS INTERFACE m_axi port = in2 bundle = gmem1
+#pragma HLS INTERFACE m_axi port = out bundle = gmem0
+    vadd_beats<float>(in1, in2, out, size);
+}
+
+void vadd_half(const hls::vector<half, 32>* in1,
+               const hls::vector<half, 32>* in2,
+               hls::vector<half, 32>* out,
+               int size) {
+#pragma HLS INTERFACE m_axi port = in1 bundle = gmem0
+#pragma HLS INTERFACE m_axi port = in2 bundle = gmem1
+#pragma HLS INTERFACE m_axi port = out bundle = gmem0
+    vadd_beats<half>(in1, in2, out, size);
+}
+}
@@ -0,0 +1,180 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+
+
+#include "bench.h"
+#include "cmdlineparser.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "xcl2.hpp"
+
+// XRT includes
+#include "experimental/xrt_bo.h"
+#include "experimental/xrt_device.h"
+#include "experimental/xrt_kernel.h"
+
+#define DATA_SIZE 4096
+#define MAX_LANES 16
+
+// Widths built into the xclbin as vadd_w<lanes>, see src/vadd_wide.cpp
+static const int lane_counts[] = {1, 2, 4, 8, 16};
+
+static bool is_built(uint64_t lanes) {
+    return std::count(std::begin(lane_counts), std::end(lane_counts), lanes) != 0;
+}
+
+int main(int argc, char** argv) {
+    // Command Line Parser
+    sda::utils::CmdLineParser parser;
+
+    // Switches
+    //**************//"<Full Arg>",  "<Short Arg>", "<Description>", "<Default>"
+    parser.addSwitch("--xclbin_file", "-x", "input binary file string", "");
+    parser.addSwitch("--device_id", "-d", "device index", "0");
+    parser.addSwitch("--size", "-s", "vector sizes in bytes to sweep, e.g. 64K:256M:x4", "64K:256M:x4");
+    parser.addSwitch("--lanes", "-l", "kernel widths to sweep, any of 1,2,4,8,16", "1,2,4,8,16");
+    parser.parse(argc, argv);
+
+    // Read settings
+    std::string binaryFile = parser.value("xclbin_file");
+    int device_index = stoi(parser.value("device_id"));
+
+    if (argc < 3) {
+        parser.printHelp();
+        return EXIT_FAILURE;
+    }
+
+    std::vector<uint64_t> sizes = parser.value_to_sweep("size");
+    std::vector<uint64_t> lanes = parser.value_to_sweep("lanes");
+    if (sizes.empty() || lanes.empty() || std::count(sizes.begin(), sizes.end(), 0) ||
+        !std::all_of(lanes.begin(), lanes.end(), is_built)) {
+        parser.printHelp();
+        return EXIT_FAILURE;
+    }
+    if (xcl::is_emulation() && !parser.isValid("size")) {
+        sizes = {16 * 1024};
+        std::cout << "Vector size is reduced for faster execution on emulation flow.\n";
+    }
+
+    // Sizes that are not a multiple of any width, checked against the scalar kernel
+    std::vector<int> check_sizes = {1, MAX_LANES - 1, MAX_LANES + 1, DATA_SIZE - 1, DATA_SIZE + 3};
+
+    // Every kernel moves whole vectors, so the buffers are rounded up to the widest one
+    size_t max_elements = std::max<size_t>(*std::max_element(sizes.begin(), sizes.end()) / sizeof(int),
+                                           *std::max_element(check_sizes.begin(), check_sizes.end()));
+    max_elements = (max_elements + MAX_LANES - 1) / MAX_LANES * MAX_LANES;
+    size_t vector_size_bytes = max_elements * sizeof(int);
+
+    std::cout << "Open the device" << device_index << std::endl;
+    auto device = xrt::device(device_index);
+    std::cout << "Load the xclbin " << binaryFile << std::endl;
+    auto uuid = device.load_xclbin(binaryFile);
+
+    auto krnl = xrt::kernel(device, uuid, "vadd");
+    std::vector<xrt::kernel> krnl_wide;
+    for (int l : lane_counts) krnl_wide.push_back(xrt::kernel(device, uuid, "vadd_w" + std::to_string(l)));
+
+    std::cout << "Allocate Buffer in Global Memory\n";
+    auto bo0 = xrt::bo(device, vector_size_bytes, krnl.group_id(0));
+    auto bo1 = xrt::bo(device, vector_size_bytes, krnl.group_id(1));
+    auto bo_out = xrt::bo(device, vector_size_bytes, krnl.group_id(2));
+    auto bo_ref = xrt::bo(device, vector_size_bytes, krnl.group_id(2));
+
+    auto bo0_map = bo0.map<unsigned int*>();
+    auto bo1_map = bo1.map<unsigned int*>();
+    auto bo_out_map = bo_out.map<unsigned int*>();
+    auto bo_ref_map = bo_ref.map<unsigned int*>();
+    for (size_t i = 0; i < max_elements; i++) {
+        bo0_map[i] = i;
+        bo1_map[i] = 0x01010101u * (i & 0xff);
+    }
+
+    std::cout << "synchronize input buffer data to device global memory\n";
+    bo0.sync(XCL_BO_SYNC_BO_TO_DEVICE);
+    bo1.sync(XCL_BO_SYNC_BO_TO_DEVICE);
+
+    // The lanes of the last vector past size must come back as zero, so the
+    // output starts out filled with something else
+    std::fill(bo_out_map, bo_out_map + max_elements, 0xdeadbeef);
+
+    bool match = true;
+    for (int size : check_sizes) {
+        auto run = krnl(bo0, bo1, bo_ref, size);
+        run.wait();
+        bo_ref.sync(XCL_BO_SYNC_BO_FROM_DEVICE, size * sizeof(int), 0);
+
+        for (size_t k = 0; k < krnl_wide.size(); k++) {
+            size_t padded = (size + lane_counts[k] - 1) / lane_counts[k] * lane_counts[k];
+            bo_out.sync(XCL_BO_SYNC_BO_TO_DEVICE, padded * sizeof(int), 0);
+            auto run = krnl_wide[k](bo0, bo1, bo_out, size);
+            run.wait();
+            bo_out.sync(XCL_BO_SYNC_BO_FROM_DEVICE, padded * sizeof(int), 0);
+
+            for (size_t i = 0; i < padded; i++) {
+                unsigned int expected = i < (size_t)size ? bo_ref_map[i] : 0;
+                if (bo_out_map[i] != expected) {
+                    printf("vadd_w%d, size %d: element %zu is 0x%x, expected 0x%x\n", lane_counts[k], size, i,
+                           bo_out_map[i], expected);
+                    match = false;
+                    break;
+                }
+            }
+            std::fill(bo_out_map, bo_out_map + padded, 0xdeadbeef);
+        }
+    }
+    if (!match) {
+        std::cout << "TEST FAILED\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << "Wide kernels match vadd on " << check_sizes.size() << " sizes that are not a multiple of the width"
+              << std::endl;
+
+    xcl::bench_options bench_opts;
+    if (xcl::is_emulation()) {
+        bench_opts.warmup = 0;
+        bench_opts.repetitions = 1;
+    }
+    xcl::benchmark bench("vadd_wide", bench_opts.from_env());
+
+    // One row per size, one GB/s column per width; two reads and one write per element
+    printf("%12s", "Size");
+    for (uint64_t l : lanes) printf("  %2d lane%s", (int)l, l > 1 ? "s" : " ");
+    printf("\n");
+    for (uint64_t bytes : sizes) {
+        int size = bytes / sizeof(int);
+        double gb = 3.0 * size * sizeof(int) / 1e9;
+        printf("%10lluKB", (unsigned long long)bytes / 1024);
+        for (uint64_t l : lanes) {
+            auto& k = krnl_wide[std::find(std::begin(lane_counts), std::end(lane_counts), l) - lane_counts];
+            auto& result = bench.run("vadd_w" + std::to_string(l) + " " + std::to_string(bytes) + " bytes",
+                                     [&] {
+                                         auto run = k(bo0, bo1, bo_out, size);
+                                         run.wait();
+                                     },
+                                     gb, "GB/s");
+            printf(" %9.3f", result.rate());
+            fflush(stdout);
+        }
+        printf(" GB/s\n");
+    }
+    bench.save();
+
+    std::cout << "TEST PASSED\n";
+    return 0;
+}
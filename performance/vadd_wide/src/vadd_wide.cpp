@@ -0,0 +1,194 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+
+
+/*******************************************************************************
+Description:
+    Wide datapath variant of the hello_world vector addition. The scalar vadd
+    moves one unsigned int per clock cycle through each 64 byte port, which
+    uses 1/16 of the port bandwidth. Here the load, compute and store
+    functions work on hls::vector<unsigned int, LANES>, so each port carries
+    LANES integers per clock cycle and LANES adders run in parallel.
+
+    LANES is a template parameter, a power of two from 1 to 16. The kernels
+    vadd_w1, vadd_w2, vadd_w4, vadd_w8 and vadd_w16 instantiate it at 4, 8,
+    16, 32 and 64 bytes per clock cycle, so the host can compare them in one
+    xclbin.
+
+    size is in integers and does not have to be a multiple of LANES. The
+    kernel moves (size + LANES - 1) / LANES vectors, so the buffers must hold
+    a whole number of vectors, and it writes zero to the lanes of the last
+    output vector that are past size.
+                                       _____________
+                                      |             |<----- Input Vector 1 from Global Memory
+                                      |  load_input |       __
+                                      |_____________|----->|  |
+                                       _____________       |  | in1_stream
+Input Vector 2 from Global Memory --->|             |      |__|
+                               __     |  load_input |        |
+                              |  |<---|_____________|        |
+                   in2_stream |  |     _____________         |
+                              |__|--->|             |<--------
+                                      | compute_add |      __
+                                      |_____________|---->|  |
+                                       ______________     |  | out_stream
+                                      |              |<---|__|
+                                      | store_result |
+                                      |______________|-----> Output result to Global Memory
+
+*******************************************************************************/
+
+#include <stdint.h>
+#include <hls_stream.h>
+#include <hls_vector.h>
+
+#define DATA_SIZE 4096
+
+// TRIPCOUNT identifiers, in vectors of the widest kernel and of the scalar one
+const int c_min_words = DATA_SIZE / 16;
+const int c_max_words = DATA_SIZE;
+
+template <int LANES>
+struct vadd_types {
+    static_assert(LANES >= 1 && LANES <= 16, "a 512 bit port holds 1 to 16 integers");
+    // hls::vector rounds its size up to a power of two, other widths would
+    // leave gaps between the vectors in global memory
+    static_assert((LANES & (LANES - 1)) == 0, "LANES must be a power of two");
+    typedef hls::vector<unsigned int, LANES> vec_t;
+};
+
+template <int LANES>
+static void read_input(const typename vadd_types<LANES>::vec_t* in,
+                       hls::stream<typename vadd_types<LANES>::vec_t>& inStream,
+                       int words) {
+// Auto-pipeline is going to apply pipeline to this loop
+mem_rd:
+    for (int i = 0; i < words; i++) {
+#pragma HLS LOOP_TRIPCOUNT min = c_min_words max = c_max_words
+        inStream << in[i];
+    }
+}
+
+template <int LANES>
+static void compute_add(hls::stream<typename vadd_types<LANES>::vec_t>& inStream1,
+                        hls::stream<typename vadd_types<LANES>::vec_t>& inStream2,
+                        hls::stream<typename vadd_types<LANES>::vec_t>& outStream,
+                        int words,
+                        int size) {
+// Auto-pipeline is going to apply pipeline to this loop
+execute:
+    for (int i = 0; i < words; i++) {
+#pragma HLS LOOP_TRIPCOUNT min = c_min_words max = c_max_words
+        typename vadd_types<LANES>::vec_t sum = inStream1.read() + inStream2.read();
+    // Lanes past size only exist in the last vector, they are padding
+    tail:
+        for (int l = 0; l < LANES; l++) {
+#pragma HLS UNROLL
+            if (i * LANES + l >= size) sum[l] = 0;
+        }
+        outStream << sum;
+    }
+}
+
+template <int LANES>
+static void write_result(typename vadd_types<LANES>::vec_t* out,
+                         hls::stream<typename vadd_types<LANES>::vec_t>& outStream,
+                         int words) {
+// Auto-pipeline is going to apply pipeline to this loop
+mem_wr:
+    for (int i = 0; i < words; i++) {
+#pragma HLS LOOP_TRIPCOUNT min = c_min_words max = c_max_words
+        out[i] = outStream.read();
+    }
+}
+
+template <int LANES>
+static void vadd_wide(const typename vadd_types<LANES>::vec_t* in1,
+                      const typename vadd_types<LANES>::vec_t* in2,
+                      typename vadd_types<LANES>::vec_t* out,
+                      int size) {
+    hls::stream<typename vadd_types<LANES>::vec_t> inStream1("input_stream_1");
+    hls::stream<typename vadd_types<LANES>::vec_t> inStream2("input_stream_2");
+    hls::stream<typename vadd_types<LANES>::vec_t> outStream("output_stream");
+    int words = (size + LANES - 1) / LANES;
+
+#pragma HLS dataflow
+    // dataflow pragma instruct compiler to run following three APIs in parallel
+    read_input<LANES>(in1, inStream1, words);
+    read_input<LANES>(in2, inStream2, words);
+    compute_add<LANES>(inStream1, inStream2, outStream, words, size);
+    write_result<LANES>(out, outStream, words);
+}
+
+extern "C" {
+/*
+    Vector Addition Kernels, LANES integers per clock cycle
+    Arguments:
+        in1   (input)  --> Input Vector 1
+        in2   (input)  --> Input Vector 2
+        out  (output) --> Output Vector
+        size (input)  --> Size of Vector in Integer
+   */
+void vadd_w1(const hls::vector<unsigned int, 1>* in1,
+             const hls::vector<unsigned int, 1>* in2,
+             hls::vector<unsigned int, 1>* out,
+             int size) {
+#pragma HLS INTERFACE m_axi port = in1 bundle = gmem0
+#pragma HLS INTERFACE m_axi port = in2 bundle = gmem1
+#pragma HLS INTERFACE m_axi port = out bundle = gmem0
+    vadd_wide<1>(in1, in2, out, size);
+}
+
+void vadd_w2(const hls::vector<unsigned int, 2>* in1,
+             const hls::vector<unsigned int, 2>* in2,
+             hls::vector<unsigned int, 2>* out,
+             int size) {
+#pragma HLS INTERFACE m_axi port = in1 bundle = gmem0
+#pragma HLS INTERFACE m_axi port = in2 bundle = gmem1
+#pragma HLS INTERFACE m_axi port = out bundle = gmem0
+    vadd_wide<2>(in1, in2, out, size);
+}
+
+void vadd_w4(const hls::vector<unsigned int, 4>* in1,
+             const hls::vector<unsigned int, 4>* in2,
+             hls::vector<unsigned int, 4>* out,
+             int size) {
+#pragma HLS INTERFACE m_axi port = in1 bundle = gmem0
+#pragma HLS INTERFACE m_axi port = in2 bundle = gmem1
+#pragma HLS INTERFACE m_axi port = out bundle = gmem0
+    vadd_wide<4>(in1, in2, out, size);
+}
+
+void vadd_w8(const hls::vector<unsigned int, 8>* in1,
+             const hls::vector<unsigned int, 8>* in2,
+             hls::vector<unsigned int, 8>* out,
+             int size) {
+#pragma HLS INTERFACE m_axi port = in1 bundle = gmem0
+#pragma HLS INTERFACE m_axi port = in2 bundle = gmem1
+#pragma HLS INTERFACE m_axi port = out bundle = gmem0
+    vadd_wide<8>(in1, in2, out, size);
+}
+
+void vadd_w16(const hls::vector<unsigned int, 16>* in1,
+              const hls::vector<unsigned int, 16>* in2,
+              hls::vector<unsigned int, 16>* out,
+              int size) {
+#pragma HLS INTERFACE m_axi port = in1 bundle = gmem0
+#pragma HLS INTERFACE m_axi port = in2 bundle = gmem1
+#pragma HLS INTERFACE m_axi port = out bundle = gmem0
+    vadd_wide<16>(in1, in2, out, size);
+}
+}
@@ -46,8 +46,6 @@ int main(int argc, char** argv) {
     }
 
     cl_int err;
-    cl::Context context;
-    cl::CommandQueue q;
     std::vector<int, aligned_allocator<int> > h_a(LENGTH);    // host memory for a vector
     std::vector<int, aligned_allocator<int> > h_b(LENGTH);    // host memory for b vector
     std::vector<int, aligned_allocator<int> > h_temp(LENGTH); // host memory for temp vector
@@ -71,28 +69,28 @@ int main(int argc, char** argv) {
     // unless all the cl buffers are released before calling cl::Program a second
     // time in the same process. The code block below is in braces because the cl
     // objects
-    // are automatically released once the block ends
-    std::string vmulBinaryFile = binaryFile1.c_str();
-    auto fileBuf_vmul = xcl::read_binary_file(vmulBinaryFile);
-    cl::Program::Binaries vmul_bins{{fileBuf_vmul.data(), fileBuf_vmul.size()}};
-    auto vaddBinaryFile = binaryFile2.c_str();
-    auto fileBuf_vadd = xcl::read_binary_file(vaddBinaryFile);
-    cl::Program::Binaries vadd_bins{{fileBuf_vadd.data(), fileBuf_vadd.size()}};
+    // are automatically released once the block ends.
+    // The programs come from the process wide program cache: it reprograms the
+    // device only when the requested xclbin differs from the one already
+    // loaded, and drops the previous program before doing so.
+    auto& cache = xcl::program_cache::instance();
+    xcl::binary_file vmul_bin(binaryFile1);
+    xcl::binary_file vadd_bin(binaryFile2);
     bool valid_device = false;
     for (unsigned int i = 0; i < devices.size(); i++) {
         auto device = devices[i];
-        // Creating Context and Command Queue for selected Device
-        OCL_CHECK(err, context = cl::Context(device, nullptr, nullptr, nullptr, &err));
-        OCL_CHECK(err, q = cl::CommandQueue(context, device, CL_QUEUE_PROFILING_ENABLE, &err));
         std::cout << "Trying to program device[" << i << "]: " << device.getInfo<CL_DEVICE_NAME>() << std::endl;
         {
-            cl::Program program_vmul(context, {device}, vmul_bins, nullptr, &err);
+            auto program_vmul = cache.get(device, vmul_bin, &err);
             if (err != CL_SUCCESS) {
                 std::cout << "Failed to program device[" << i << "] with xclbin file!\n";
             } else {
                 std::cout << "Device[" << i << "]: program successful!\n";
+                auto& context = program_vmul->context;
+                // Creating Command Queue for selected Device
+                OCL_CHECK(err, cl::CommandQueue q(context, device, CL_QUEUE_PROFILING_ENABLE, &err));
                 printf("INFO: loading vmul kernel\n");
-                OCL_CHECK(err, cl::Kernel krnl_vmul(program_vmul, "krnl_vmul", &err));
+                OCL_CHECK(err, cl::Kernel krnl_vmul = cache.get_kernel(program_vmul, "krnl_vmul", &err));
                 OCL_CHECK(err, cl::Buffer d_a(context, CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY, sizeof(int) * LENGTH,
                                               h_a.data(), &err));
                 OCL_CHECK(err, cl::Buffer d_b(context, CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY, sizeof(int) * LENGTH,
@@ -125,13 +123,15 @@ int main(int argc, char** argv) {
         }
         {
             if (match) {
-                cl::Program program_vadd(context, {device}, vadd_bins, nullptr, &err);
+                auto program_vadd = cache.get(device, vadd_bin, &err);
                 if (err != CL_SUCCESS) {
                     std::cout << "Failed to program device[" << i << "] with xclbin file!\n";
                 } else {
                     std::cout << "Device[" << i << "]: program successful!\n";
+                    auto& context = program_vadd->context;
+                    OCL_CHECK(err, cl::CommandQueue q(context, device, CL_QUEUE_PROFILING_ENABLE, &err));
                     printf("INFO: loading vadd_krnl\n");
-                    OCL_CHECK(err, cl::Kernel krnl_vadd(program_vadd, "krnl_vadd", &err));
+                    OCL_CHECK(err, cl::Kernel krnl_vadd = cache.get_kernel(program_vadd, "krnl_vadd", &err));
                     // Need to create the buffer and allocate the memory for the dynamic
                     // platforms
                     cl::Buffer d_temp(context, CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY, sizeof(int) * LENGTH,
@@ -171,6 +171,8 @@ int main(int argc, char** argv) {
         exit(EXIT_FAILURE);
     }
 
+    cache.print_stats();
+    cache.clear();
     std::cout << "TEST " << (match ? "PASSED" : "FAILED") << std::endl;
     return (match ? EXIT_SUCCESS : EXIT_FAILURE);
 }
@@ -21,6 +21,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <thread>
 #include <unistd.h>
 #include <vector>
 
@@ -28,7 +29,6 @@ using std::array;
 using std::map;
 using std::vector;
 
-cl::Program load_cl2_binary(cl::Program::Binaries, cl::Device device, cl::Context context);
 // This example demonstrates how to split work among multiple devices.
 int main(int argc, char** argv) {
     if (argc != 3) {
@@ -51,85 +51,99 @@ int main(int argc, char** argv) {
     static const int elements_per_device = xcl::is_hw_emulation() ? (1 << 10) : (1 << 20);
     static const int elements = elements_per_device * device_count;
 
-    vector<int, aligned_allocator<int> > A(elements, 32);
-    vector<int, aligned_allocator<int> > B(elements, 10);
-    vector<int, aligned_allocator<int> > C(elements);
-
     // One element per device
-    vector<cl::Context> contexts(device_count);
-    vector<cl::Program> programs(device_count);
-    vector<cl::Kernel> kernels(device_count);
-    vector<cl::CommandQueue> queues(device_count);
-    vector<std::string> device_name(device_count);
+    // Host buffers are split per device and placed on the NUMA node the card
+    // is attached to, so DMA does not cross the socket interconnect.
+    typedef vector<int, numa_allocator<int> > host_buffer;
+    vector<int> nodes(device_count);
+    vector<host_buffer> A, B, C;
+    A.reserve(device_count);
+    B.reserve(device_count);
+    C.reserve(device_count);
+    for (int d = 0; d < (int)device_count; d++) {
+        nodes[d] = xcl::get_numa_node(devices[d]);
+        std::cout << "Device[" << d << "] is attached to NUMA node " << nodes[d] << std::endl;
+        A.emplace_back(elements_per_device, 32, numa_allocator<int>(nodes[d]));
+        B.emplace_back(elements_per_device, 10, numa_allocator<int>(nodes[d]));
+        C.emplace_back(elements_per_device, 0, numa_allocator<int>(nodes[d]));
+    }
 
     vector<cl::Buffer> buffer_a(device_count);
     vector<cl::Buffer> buffer_b(device_count);
     vector<cl::Buffer> buffer_result(device_count);
-    vector<cl::Program::Binaries> bins(device_count);
-    vector<cl::Platform> platform;
-    std::vector<unsigned char> fileBuf[device_count];
-    OCL_CHECK(err, err = cl::Platform::get(&platform));
 
     size_t size_per_device = elements_per_device * sizeof(int);
     static const int iter = xcl::is_hw_emulation() ? 2 : 10 * 1024;
     size_t total_size = iter * size_per_device * device_count * 3;
     std::string size_str = xcl::convert_size(total_size);
 
-    cl_context_properties props[3] = {CL_CONTEXT_PLATFORM, (cl_context_properties)(platform[0])(), 0};
+    // Device 0 loads the first xclbin and every other device the second one.
+    // device_group maps each distinct file once and creates the context,
+    // queue, program and kernel of all devices concurrently.
     std::cout << "Initializing OpenCL objects" << std::endl;
+    vector<std::string> xclbins(device_count, binaryFile2);
+    if (device_count) xclbins[0] = binaryFile1;
+    xcl::device_group group(devices, xclbins, {"vadd"}, CL_QUEUE_PROFILING_ENABLE);
+    group.print_stats();
+    if (!group.ok()) {
+        std::cout << "Failed to program all devices, exit!" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    vector<cl::Context> contexts(device_count);
+    vector<cl::Kernel> kernels(device_count);
+    vector<cl::CommandQueue> queues(device_count);
     for (int d = 0; d < (int)device_count; d++) {
-        // In this example. We will create a context for each of the devices
-        std::cout << "Creating Context[" << d << "]..." << std::endl;
-        OCL_CHECK(err, contexts[d] = cl::Context(devices[d], props, nullptr, nullptr, &err));
-        OCL_CHECK(err, queues[d] = cl::CommandQueue(contexts[d], devices[d], CL_QUEUE_PROFILING_ENABLE, &err));
-        OCL_CHECK(err, device_name[d] = devices[d].getInfo<CL_DEVICE_NAME>(&err));
-
-        // read_binary_file() ia a utility API which will load the binaryFile
-        // and will return pointer to file buffer.
-        fileBuf[d] = ((d == 0) ? xcl::read_binary_file(binaryFile1) : xcl::read_binary_file(binaryFile2));
-        bins[d].push_back({fileBuf[d].data(), fileBuf[d].size()});
-        programs[d] = load_cl2_binary(bins[d], devices[d], contexts[d]);
-        OCL_CHECK(err, kernels[d] = cl::Kernel(programs[d], "vadd", &err));
+        contexts[d] = group[d].context;
+        kernels[d] = group[d].kernels[0];
+        queues[d] = group[d].queue;
 
         // Allocate Buffers in Global Memory
         // Buffers are allocated using CL_MEM_USE_HOST_PTR for efficient memory and
         // Device-to-host communication
-        size_t offset = d * elements_per_device;
         std::cout << "Creating Buffers[" << d << "]..." << std::endl;
         OCL_CHECK(err, buffer_a[d] = cl::Buffer(contexts[d], CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY, size_per_device,
-                                                &A[offset], &err));
+                                                A[d].data(), &err));
         OCL_CHECK(err, buffer_b[d] = cl::Buffer(contexts[d], CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY, size_per_device,
-                                                &B[offset], &err));
+                                                B[d].data(), &err));
         OCL_CHECK(err, buffer_result[d] = cl::Buffer(contexts[d], CL_MEM_USE_HOST_PTR | CL_MEM_WRITE_ONLY,
-                                                     size_per_device, &C[offset], &err));
+                                                     size_per_device, C[d].data(), &err));
     }
 
+    // Each device is driven by its own thread running on the device's node
     std::chrono::high_resolution_clock::time_point TimeStart = std::chrono::high_resolution_clock::now();
+    vector<std::thread> workers;
     for (int d = 0; d < (int)device_count; d++) {
-        OCL_CHECK(err, err = kernels[d].setArg(0, buffer_result[d]));
-        OCL_CHECK(err, err = kernels[d].setArg(1, buffer_a[d]));
-        OCL_CHECK(err, err = kernels[d].setArg(2, buffer_b[d]));
-        OCL_CHECK(err, err = kernels[d].setArg(3, elements_per_device));
-        OCL_CHECK(err, err = kernels[d].setArg(4, iter));
-
-        // Copy input data to device global memory
-        std::cout << "Copying data..." << std::endl;
-        OCL_CHECK(err, err = queues[d].enqueueMigrateMemObjects({buffer_a[d], buffer_b[d]}, 0 /*0 means from host*/));
-
-        // Launch the Kernel
-        std::cout << "Launching Kernel..." << std::endl;
-        OCL_CHECK(err, err = queues[d].enqueueTask(kernels[d]));
-
-        // Copy Result from Device Global Memory to Host Local Memory
-        std::cout << "Getting Results..." << std::endl;
-        OCL_CHECK(err, err = queues[d].enqueueMigrateMemObjects({buffer_result[d]}, CL_MIGRATE_MEM_OBJECT_HOST));
+        workers.emplace_back([&, d] {
+            cl_int err;
+            if (nodes[d] >= 0 && !xcl::bind_thread_to_node(nodes[d])) {
+                std::cout << "WARNING: Unable to bind thread of device " << d << " to NUMA node " << nodes[d]
+                          << std::endl;
+            }
+            OCL_CHECK(err, err = kernels[d].setArg(0, buffer_result[d]));
+            OCL_CHECK(err, err = kernels[d].setArg(1, buffer_a[d]));
+            OCL_CHECK(err, err = kernels[d].setArg(2, buffer_b[d]));
+            OCL_CHECK(err, err = kernels[d].setArg(3, elements_per_device));
+            OCL_CHECK(err, err = kernels[d].setArg(4, iter));
+
+            // Copy input data to device global memory
+            OCL_CHECK(err,
+                      err = queues[d].enqueueMigrateMemObjects({buffer_a[d], buffer_b[d]}, 0 /*0 means from host*/));
+
+            // Launch the Kernel
+            OCL_CHECK(err, err = queues[d].enqueueTask(kernels[d]));
+
+            // Copy Result from Device Global Memory to Host Local Memory
+            OCL_CHECK(err, err = queues[d].enqueueMigrateMemObjects({buffer_result[d]}, CL_MIGRATE_MEM_OBJECT_HOST));
+            OCL_CHECK(err, err = queues[d].flush());
+            OCL_CHECK(err, err = queues[d].finish());
+        });
     }
 
     int dev = 0;
-    for (auto queue : queues) {
+    for (auto& worker : workers) {
         std::cout << "Waiting for work to finish on device " << dev++ << std::endl;
-        OCL_CHECK(err, err = queue.flush());
-        OCL_CHECK(err, err = queue.finish());
+        worker.join();
     }
 
     std::chrono::high_resolution_clock::time_point TimeEnd = std::chrono::high_resolution_clock::now();
@@ -137,13 +151,14 @@ int main(int argc, char** argv) {
 
     // OPENCL HOST CODE AREA ENDS
     bool match = true;
-    for (int i = 0; i < elements; i++) {
-        int host_result = A[i] + B[i];
-        if (C[i] != host_result) {
+    for (int i = 0; i < elements && match; i++) {
+        int d = i / elements_per_device;
+        int j = i % elements_per_device;
+        int host_result = A[d][j] + B[d][j];
+        if (C[d][j] != host_result) {
             std::cout << "Error: Result mismatch" << std::endl;
-            std::cout << "i = " << i << " CPU result = " << host_result << " Device result = " << C[i] << std::endl;
+            std::cout << "i = " << i << " CPU result = " << host_result << " Device result = " << C[d][j] << std::endl;
             match = false;
-            break;
         }
     }
     std::cout << "Total Size : " << size_str << std::endl;
@@ -151,10 +166,3 @@ int main(int argc, char** argv) {
     std::cout << "TEST " << (match ? "PASSED" : "FAILED") << std::endl;
     return (match ? EXIT_SUCCESS : EXIT_FAILURE);
 }
-
-cl::Program load_cl2_binary(cl::Program::Binaries bins, cl::Device device, cl::Context context) {
-    cl_int err;
-    std::vector<cl::Device> devices(1, device);
-    OCL_CHECK(err, cl::Program program(context, devices, bins, nullptr, &err));
-    return program;
-}